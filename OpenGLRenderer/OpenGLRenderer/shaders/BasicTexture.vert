@@ -4,12 +4,83 @@ layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
 
 out vec2 texCoord;
+out vec3 normal;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Written per draw into the frame's ring buffer region (see ObjectConstants in Model.cpp)
+layout (std140, binding = 1) uniform ObjectConstants {
+    mat4 model;
+    mat4 normalMatrix;
+};
+
+// Written once per frame into the ring buffer and shared by every program (see FrameConstants.h)
+layout (std140, binding = 0) uniform FrameConstants {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec2 time;
+    vec2 viewport;
+};
+
+// Set for meshes uploaded as CompactVertex: aPos is unorm16 within the mesh bounds and aNormal.xy is octahedral
+uniform bool compactVertices;
+
+// Per-mesh constants, indexed by the draw's base instance (see MeshDrawData)
+struct MeshDrawData {
+    vec4 positionOffset;
+    vec4 positionScale;
+};
+
+layout (std430, binding = 0) readonly buffer MeshDrawDataBuffer {
+    MeshDrawData meshDrawData[];
+};
+
+// Set when no attributes are bound and vertices are read from the pool's vertex buffer instead.
+// gl_VertexID already includes the draw's base vertex.
+uniform bool vertexPulling;
+
+layout (std430, binding = 1) readonly buffer VertexBuffer {
+    uint vertexWords[];
+};
+
+// Same encodings the attribute formats describe for Vertex and CompactVertex
+void PullVertex(out vec3 position, out vec3 normal, out vec2 texCoord) {
+    if (compactVertices) {
+        uint base = uint(gl_VertexID) * 4u;
+        position = vec3(unpackUnorm2x16(vertexWords[base]), unpackUnorm2x16(vertexWords[base + 1u]).x);
+        normal = vec3(unpackSnorm2x16(vertexWords[base + 2u]), 0.0);
+        texCoord = unpackHalf2x16(vertexWords[base + 3u]);
+    }
+    else {
+        uint base = uint(gl_VertexID) * 8u;
+        position = uintBitsToFloat(uvec3(vertexWords[base], vertexWords[base + 1u], vertexWords[base + 2u]));
+        normal = uintBitsToFloat(uvec3(vertexWords[base + 3u], vertexWords[base + 4u], vertexWords[base + 5u]));
+        texCoord = uintBitsToFloat(uvec2(vertexWords[base + 6u], vertexWords[base + 7u]));
+    }
+}
+
+vec3 DecodeOctahedral(vec2 encoded) {
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
 
 void main() {
-    texCoord = aTexCoord;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vec3 position = aPos;
+    vec3 objectNormal = aNormal;
+    vec2 vertexTexCoord = aTexCoord;
+    if (vertexPulling) {
+        PullVertex(position, objectNormal, vertexTexCoord);
+    }
+
+    if (compactVertices) {
+        MeshDrawData drawData = meshDrawData[gl_BaseInstance];
+        position = drawData.positionOffset.xyz + position * drawData.positionScale.xyz;
+        objectNormal = DecodeOctahedral(objectNormal.xy);
+    }
+
+    texCoord = vertexTexCoord;
+    normal = mat3(normalMatrix) * objectNormal;
+    gl_Position = viewProjection * model * vec4(position, 1.0);
 }
\ No newline at end of file
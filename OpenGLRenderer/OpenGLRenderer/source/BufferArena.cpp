@@ -0,0 +1,81 @@
+#include "BufferArena.h"
+#include "glad/glad.h"
+
+#include <algorithm>
+#include <iostream>
+
+BufferArena::BufferArena(uint32_t elementSize, uint32_t initialCapacity) : allocator(0) {
+	this->elementSize = elementSize;
+	CreateStorage(initialCapacity);
+}
+
+uint32_t BufferArena::Allocate(uint32_t count, bool allowGrowth) {
+	uint32_t offset = allocator.Allocate(count);
+	// Growing cannot help an empty request
+	if (offset != TlsfAllocator::INVALID_OFFSET || !allowGrowth || count == 0) {
+		return offset;
+	}
+
+	uint64_t capacity = allocator.GetStats().capacity;
+	uint64_t newCapacity = std::max<uint64_t>(capacity * 2, capacity + count);
+	if (newCapacity * elementSize > UINT32_MAX) {
+		std::cout << "ERROR: Buffer arena cannot grow past 4 GB\n";
+		return TlsfAllocator::INVALID_OFFSET;
+	}
+
+	CreateStorage(static_cast<uint32_t>(newCapacity));
+	return allocator.Allocate(count);
+}
+
+void BufferArena::FreeDeferred(uint32_t offset, uint64_t frameSerial) {
+	pendingFrees.push_back(PendingFree{ offset, frameSerial });
+}
+
+void BufferArena::Retire(uint64_t completedSerial) {
+	auto retired = std::remove_if(pendingFrees.begin(), pendingFrees.end(), [&](const PendingFree& pending) {
+		if (pending.frameSerial > completedSerial) {
+			return false;
+		}
+		allocator.Free(pending.offset);
+		return true;
+	});
+	pendingFrees.erase(retired, pendingFrees.end());
+}
+
+void BufferArena::FreeImmediately(uint32_t offset) {
+	allocator.Free(offset);
+}
+
+void BufferArena::Upload(uint32_t offset, const void* data, uint32_t count) {
+	glNamedBufferSubData(buffer.GetName(), static_cast<GLintptr>(offset) * elementSize, static_cast<GLsizeiptr>(count) * elementSize, data);
+}
+
+void BufferArena::CopyFrom(uint32_t sourceBuffer, size_t sourceByteOffset, uint32_t offset, uint32_t count) {
+	glCopyNamedBufferSubData(sourceBuffer, buffer.GetName(), static_cast<GLintptr>(sourceByteOffset), static_cast<GLintptr>(offset) * elementSize,
+		static_cast<GLsizeiptr>(count) * elementSize);
+}
+
+void BufferArena::Copy(uint32_t sourceOffset, uint32_t destinationOffset, uint32_t count) {
+	glCopyNamedBufferSubData(buffer.GetName(), buffer.GetName(), static_cast<GLintptr>(sourceOffset) * elementSize, static_cast<GLintptr>(destinationOffset) * elementSize,
+		static_cast<GLsizeiptr>(count) * elementSize);
+}
+
+void BufferArena::Destroy() {
+	buffer.Reset();
+}
+
+void BufferArena::CreateStorage(uint32_t capacity) {
+	uint32_t storage;
+	glCreateBuffers(1, &storage);
+	glNamedBufferStorage(storage, static_cast<GLsizeiptr>(capacity) * elementSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	// Live ranges keep their offsets, so the old contents are copied over as they are
+	if (buffer.GetName() != 0) {
+		glCopyNamedBufferSubData(buffer.GetName(), storage, 0, 0, static_cast<GLsizeiptr>(allocator.GetStats().capacity) * elementSize);
+		growthCount++;
+	}
+
+	// The old buffer may still be read by frames in flight, so the registry deletes it once they finish
+	buffer = GpuResource(GpuResourceType::Buffer, storage, static_cast<size_t>(capacity) * elementSize);
+	allocator.Grow(capacity);
+}
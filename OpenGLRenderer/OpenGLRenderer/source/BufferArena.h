@@ -0,0 +1,63 @@
+#pragma once
+
+#include "TlsfAllocator.h"
+#include "GpuResources.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// One immutable GL buffer (glNamedBufferStorage) carved into element ranges by a TLSF allocator.
+// When it fills up it is replaced by one twice the size; callers must re-point anything that
+// referenced GetBuffer(). Frees are deferred until the GPU has finished the frame that last used them.
+class BufferArena {
+public:
+	BufferArena(uint32_t elementSize, uint32_t initialCapacity);
+
+	BufferArena(const BufferArena&) = delete;
+	BufferArena& operator=(const BufferArena&) = delete;
+
+	// Returns TlsfAllocator::INVALID_OFFSET for a count of 0, or if growing is not allowed or impossible
+	uint32_t Allocate(uint32_t count, bool allowGrowth = true);
+
+	// Releases the range once frameSerial is reported complete to Retire
+	void FreeDeferred(uint32_t offset, uint64_t frameSerial);
+
+	// Returns deferred ranges whose frame the GPU has finished
+	void Retire(uint64_t completedSerial);
+
+	// For ranges no draw has referenced yet
+	void FreeImmediately(uint32_t offset);
+
+	void Upload(uint32_t offset, const void* data, uint32_t count);
+
+	// GPU-side copy from another buffer into a range of this one
+	void CopyFrom(uint32_t sourceBuffer, size_t sourceByteOffset, uint32_t offset, uint32_t count);
+
+	// GPU-side copy between two non-overlapping ranges of this buffer
+	void Copy(uint32_t sourceOffset, uint32_t destinationOffset, uint32_t count);
+
+	uint32_t GetBuffer() const { return buffer.GetName(); }
+
+	uint32_t GetElementSize() const { return elementSize; }
+
+	const TlsfStats& GetStats() const { return allocator.GetStats(); }
+
+	uint32_t GetGrowthCount() const { return growthCount; }
+
+	void Destroy();
+
+private:
+	struct PendingFree {
+		uint32_t offset;
+		uint64_t frameSerial;
+	};
+
+	uint32_t elementSize;
+	GpuResource buffer;
+	uint32_t growthCount = 0;
+	TlsfAllocator allocator;
+	std::vector<PendingFree> pendingFrees;
+
+	void CreateStorage(uint32_t capacity);
+};
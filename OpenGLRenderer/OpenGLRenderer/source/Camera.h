@@ -23,6 +23,8 @@ public:
 
 	float GetZoom() const { return zoom; }
 
+	const glm::vec3& GetPosition() const { return position; }
+
 	void SetSpeed(float speed) { movementSpeed = speed; }
 
 private:
@@ -0,0 +1,110 @@
+#include "CommandList.h"
+#include "glad/glad.h"
+#include "GLState.h"
+
+#include <cstring>
+
+namespace {
+	// Arguments are stored unaligned, so they are copied out rather than read in place
+	template <typename Args>
+	Args Read(const uint8_t*& cursor) {
+		Args args;
+		std::memcpy(&args, cursor, sizeof(Args));
+		cursor += sizeof(Args);
+		return args;
+	}
+}
+
+template <typename Args>
+void CommandList::Append(CommandType type, const Args& args) {
+	size_t offset = bytes.size();
+	bytes.resize(offset + 1 + sizeof(Args));
+	bytes[offset] = static_cast<uint8_t>(type);
+	std::memcpy(&bytes[offset + 1], &args, sizeof(Args));
+	stats.commands++;
+	stats.bytes = bytes.size();
+}
+
+void CommandList::Clear() {
+	// Keeps the capacity, so a list reused every frame stops allocating
+	bytes.clear();
+	stats = CommandListStats();
+}
+
+void CommandList::BindVertexArray(uint32_t vertexArray) {
+	Append(CommandType::BindVertexArray, BindVertexArrayArgs{ vertexArray });
+}
+
+void CommandList::SetVertexArrayElementBuffer(uint32_t vertexArray, uint32_t buffer) {
+	Append(CommandType::SetVertexArrayElementBuffer, SetVertexArrayElementBufferArgs{ vertexArray, buffer });
+}
+
+void CommandList::BindTexture(uint32_t unit, uint32_t texture) {
+	Append(CommandType::BindTexture, BindTextureArgs{ unit, texture });
+}
+
+void CommandList::BindBufferBase(uint32_t target, uint32_t index, uint32_t buffer) {
+	Append(CommandType::BindBufferBase, BindBufferBaseArgs{ target, index, buffer });
+}
+
+void CommandList::SetUniform(uint32_t program, int32_t location, int32_t value) {
+	Append(CommandType::SetUniform, SetUniformArgs{ program, location, value });
+}
+
+void CommandList::DrawElements(uint32_t indexType, uint32_t count, size_t indexByteOffset, int32_t baseVertex, uint32_t baseInstance) {
+	Append(CommandType::DrawElements, DrawElementsArgs{ indexType, count, indexByteOffset, baseVertex, baseInstance });
+	stats.drawCalls++;
+}
+
+void CommandList::MultiDrawElementsIndirect(uint32_t indexType, size_t indirectOffset, uint32_t drawCount) {
+	Append(CommandType::MultiDrawElementsIndirect, MultiDrawElementsIndirectArgs{ indexType, drawCount, indirectOffset });
+	stats.drawCalls++;
+}
+
+void CommandList::Replay(size_t indirectBaseOffset) const {
+	GLStateCache& state = GLStateCache::Instance();
+	const uint8_t* cursor = bytes.data();
+	const uint8_t* end = cursor + bytes.size();
+	while (cursor < end) {
+		CommandType type = static_cast<CommandType>(*cursor++);
+		switch (type) {
+		case CommandType::BindVertexArray: {
+			BindVertexArrayArgs args = Read<BindVertexArrayArgs>(cursor);
+			state.BindVertexArray(args.vertexArray);
+			break;
+		}
+		case CommandType::SetVertexArrayElementBuffer: {
+			SetVertexArrayElementBufferArgs args = Read<SetVertexArrayElementBufferArgs>(cursor);
+			glVertexArrayElementBuffer(args.vertexArray, args.buffer);
+			break;
+		}
+		case CommandType::BindTexture: {
+			BindTextureArgs args = Read<BindTextureArgs>(cursor);
+			state.BindTexture(args.unit, args.texture);
+			break;
+		}
+		case CommandType::BindBufferBase: {
+			BindBufferBaseArgs args = Read<BindBufferBaseArgs>(cursor);
+			state.BindBufferBase(args.target, args.index, args.buffer);
+			break;
+		}
+		case CommandType::SetUniform: {
+			SetUniformArgs args = Read<SetUniformArgs>(cursor);
+			glProgramUniform1i(args.program, args.location, args.value);
+			break;
+		}
+		case CommandType::DrawElements: {
+			DrawElementsArgs args = Read<DrawElementsArgs>(cursor);
+			glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, args.count, args.indexType, (void*)args.indexByteOffset, 1,
+				args.baseVertex, args.baseInstance);
+			break;
+		}
+		case CommandType::MultiDrawElementsIndirect: {
+			MultiDrawElementsIndirectArgs args = Read<MultiDrawElementsIndirectArgs>(cursor);
+			glMultiDrawElementsIndirect(GL_TRIANGLES, args.indexType, (void*)(indirectBaseOffset + args.indirectOffset),
+				static_cast<GLsizei>(args.drawCount), 0);
+			break;
+		}
+		}
+	}
+}
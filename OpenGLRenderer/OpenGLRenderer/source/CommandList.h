@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct CommandListStats {
+	uint32_t commands = 0;
+	uint32_t drawCalls = 0;
+	size_t bytes = 0;
+};
+
+// GL work recorded without touching GL, so any thread can fill one, then replayed on the GL thread.
+// Commands are packed back to back as a one-byte type followed by their fixed-size arguments,
+// so replay is a switch over a linear byte stream. Binds go through GLStateCache on replay,
+// which drops those made redundant by slice boundaries or by the previous list.
+class CommandList {
+public:
+	void Clear();
+
+	void BindVertexArray(uint32_t vertexArray);
+
+	void SetVertexArrayElementBuffer(uint32_t vertexArray, uint32_t buffer);
+
+	void BindTexture(uint32_t unit, uint32_t texture);
+
+	void BindBufferBase(uint32_t target, uint32_t index, uint32_t buffer);
+
+	void SetUniform(uint32_t program, int32_t location, int32_t value);
+
+	void DrawElements(uint32_t indexType, uint32_t count, size_t indexByteOffset, int32_t baseVertex, uint32_t baseInstance);
+
+	// indirectOffset is relative to the base handed to Replay, so lists can be recorded before the commands are uploaded
+	void MultiDrawElementsIndirect(uint32_t indexType, size_t indirectOffset, uint32_t drawCount);
+
+	// Executes every command in order; GL thread only
+	void Replay(size_t indirectBaseOffset) const;
+
+	bool IsEmpty() const { return bytes.empty(); }
+
+	const CommandListStats& GetStats() const { return stats; }
+
+private:
+	enum class CommandType : uint8_t {
+		BindVertexArray,
+		SetVertexArrayElementBuffer,
+		BindTexture,
+		BindBufferBase,
+		SetUniform,
+		DrawElements,
+		MultiDrawElementsIndirect
+	};
+
+	struct BindVertexArrayArgs { uint32_t vertexArray; };
+	struct SetVertexArrayElementBufferArgs { uint32_t vertexArray; uint32_t buffer; };
+	struct BindTextureArgs { uint32_t unit; uint32_t texture; };
+	struct BindBufferBaseArgs { uint32_t target; uint32_t index; uint32_t buffer; };
+	struct SetUniformArgs { uint32_t program; int32_t location; int32_t value; };
+	struct DrawElementsArgs { uint32_t indexType; uint32_t count; size_t indexByteOffset; int32_t baseVertex; uint32_t baseInstance; };
+	struct MultiDrawElementsIndirectArgs { uint32_t indexType; uint32_t drawCount; size_t indirectOffset; };
+
+	std::vector<uint8_t> bytes;
+	CommandListStats stats;
+
+	template <typename Args>
+	void Append(CommandType type, const Args& args);
+};
@@ -0,0 +1,34 @@
+#include "FrameConstants.h"
+#include "glad/glad.h"
+#include "RingBuffer.h"
+#include "GLState.h"
+#include "Shader.h"
+
+#include <iostream>
+#include <cstring>
+
+bool BindFrameConstants(const FrameConstants& constants) {
+	RingBuffer& ring = RingBuffer::Instance();
+	RingAllocation allocation = ring.Allocate(sizeof(FrameConstants), ring.GetUniformAlignment());
+	if (allocation.data == nullptr) {
+		std::cout << "ERROR: Ring buffer is full, frame constants not updated\n";
+		return false;
+	}
+
+	std::memcpy(allocation.data, &constants, sizeof(FrameConstants));
+	GLStateCache::Instance().BindBufferRange(GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, allocation.buffer, allocation.offset, sizeof(FrameConstants));
+	return true;
+}
+
+bool CheckFrameConstantsLayout(const Shader& shader) {
+	const ShaderBlockInfo* block = shader.FindUniformBlock("FrameConstants");
+	if (block == nullptr) {
+		return true;
+	}
+	if (block->binding != FRAME_CONSTANTS_BINDING || block->dataSize != sizeof(FrameConstants)) {
+		std::cout << "ERROR: FrameConstants block of shader " << shader.GetId() << " is " << block->dataSize << " bytes at binding "
+			<< block->binding << ", expected " << sizeof(FrameConstants) << " bytes at binding " << FRAME_CONSTANTS_BINDING << "\n";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+#include <cstdint>
+
+class Shader;
+
+// Per-frame values every program reads from the FrameConstants uniform block; the layout matches std140
+struct FrameConstants {
+	glm::mat4 view = glm::mat4(1.f);
+	glm::mat4 projection = glm::mat4(1.f);
+	glm::mat4 viewProjection = glm::mat4(1.f);
+	// w is padding
+	glm::vec4 cameraPosition = glm::vec4(0.f);
+	// Seconds since start and since the previous frame
+	glm::vec2 time = glm::vec2(0.f);
+	// Width and height in pixels
+	glm::vec2 viewport = glm::vec2(1.f);
+};
+
+static_assert(sizeof(FrameConstants) == 224, "FrameConstants must match the std140 block in the shaders");
+
+constexpr uint32_t FRAME_CONSTANTS_BINDING = 0;
+
+// Writes constants into this frame's ring buffer region and binds them for all programs at once.
+// Call once per frame after RingBuffer::BeginFrame; returns false if the ring is full.
+bool BindFrameConstants(const FrameConstants& constants);
+
+// Reports a program whose FrameConstants block has another size or binding; a program without one is fine
+bool CheckFrameConstantsLayout(const Shader& shader);
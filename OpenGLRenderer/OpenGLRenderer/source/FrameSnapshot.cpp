@@ -0,0 +1,63 @@
+#include "FrameSnapshot.h"
+
+#include <cstring>
+
+namespace {
+	// ImVector's assignment frees before copying; resizing keeps last frame's capacity
+	template <typename T>
+	void CopyBuffer(ImVector<T>& destination, const ImVector<T>& source) {
+		destination.resize(source.Size);
+		if (source.Size > 0) {
+			std::memcpy(destination.Data, source.Data, static_cast<size_t>(source.Size) * sizeof(T));
+		}
+	}
+}
+
+UiDrawSnapshot::~UiDrawSnapshot() {
+	for (ImDrawList* list : lists) {
+		IM_DELETE(list);
+	}
+}
+
+void UiDrawSnapshot::Capture(const ImDrawData* source, bool withTextureUpdates) {
+	drawData.Clear();
+	if (source == nullptr || !source->Valid) {
+		return;
+	}
+
+	while (lists.size() < static_cast<size_t>(source->CmdListsCount)) {
+		lists.push_back(IM_NEW(ImDrawList)(nullptr));
+	}
+
+	drawData.Valid = true;
+	drawData.DisplayPos = source->DisplayPos;
+	drawData.DisplaySize = source->DisplaySize;
+	drawData.FramebufferScale = source->FramebufferScale;
+	drawData.OwnerViewport = source->OwnerViewport;
+	drawData.Textures = withTextureUpdates ? source->Textures : nullptr;
+	for (int i = 0; i < source->CmdListsCount; i++) {
+		const ImDrawList* sourceList = source->CmdLists[i];
+		ImDrawList* list = lists[i];
+		CopyBuffer(list->CmdBuffer, sourceList->CmdBuffer);
+		CopyBuffer(list->IdxBuffer, sourceList->IdxBuffer);
+		CopyBuffer(list->VtxBuffer, sourceList->VtxBuffer);
+		list->Flags = sourceList->Flags;
+		// Not AddDrawList, which checks the write cursors of a list that was drawn into, not copied
+		drawData.CmdLists.push_back(list);
+		drawData.TotalIdxCount += list->IdxBuffer.Size;
+		drawData.TotalVtxCount += list->VtxBuffer.Size;
+	}
+	drawData.CmdListsCount = drawData.CmdLists.Size;
+}
+
+bool UiDrawSnapshot::HasTextureUpdates(const ImDrawData* source) {
+	if (source == nullptr || source->Textures == nullptr) {
+		return false;
+	}
+	for (const ImTextureData* texture : *source->Textures) {
+		if (texture->Status != ImTextureStatus_OK) {
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "IMGUI/imgui.h"
+#include "Model.h"
+#include "FrameConstants.h"
+#include "GLState.h"
+#include "RingBuffer.h"
+#include "SceneGeometry.h"
+#include "GpuResources.h"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <chrono>
+
+// A copy of ImGui's draw data that stays valid while the main thread builds the next frame's UI.
+// Lists are created and freed on the main thread only; the render thread just reads them.
+class UiDrawSnapshot {
+public:
+	UiDrawSnapshot() = default;
+
+	UiDrawSnapshot(const UiDrawSnapshot&) = delete;
+
+	UiDrawSnapshot& operator=(const UiDrawSnapshot&) = delete;
+
+	~UiDrawSnapshot();
+
+	// Copies the command, index and vertex buffers of source. Texture updates are carried only when
+	// withTextureUpdates is set, since they write to ImGui's textures and need the main thread to wait.
+	void Capture(const ImDrawData* source, bool withTextureUpdates);
+
+	bool IsValid() const { return drawData.Valid; }
+
+	ImDrawData* GetDrawData() { return &drawData; }
+
+	// True if some ImGui texture must be created, updated or destroyed by the renderer
+	static bool HasTextureUpdates(const ImDrawData* source);
+
+private:
+	ImDrawData drawData;
+	// Not registered with ImGui's shared data, so font atlas changes on the main thread never touch them
+	std::vector<ImDrawList*> lists;
+};
+
+// Work the render thread starts on behalf of the UI, carried by the snapshot of the frame it was asked in
+struct LoadRequest {
+	bool start = false;
+	std::string path;
+	ImportOptions options;
+	bool cancel = false;
+};
+
+// Everything the render thread needs to draw one frame, filled by the main thread
+struct FrameSnapshot {
+	uint64_t frameIndex = 0;
+	// When input for this frame was sampled, so latency can be measured up to the swap
+	std::chrono::steady_clock::time_point inputTime;
+
+	FrameConstants constants;
+	DrawContext drawContext;
+	bool cullBackfaces = true;
+	int framebufferWidth = 0;
+	int framebufferHeight = 0;
+
+	LoadRequest load;
+	// Per-mesh levels are copied back only while the UI shows them
+	bool wantLodDetails = false;
+
+	UiDrawSnapshot ui;
+};
+
+// One level of a mesh as the LOD panel lists it
+struct LodLevelFeedback {
+	uint32_t triangles = 0;
+	float error = 0.f;
+};
+
+struct MeshLodFeedback {
+	uint32_t activeLod = 0;
+	size_t meshlets = 0;
+	// Range in FrameFeedback::lodLevels
+	uint32_t firstLevel = 0;
+	uint32_t levelCount = 0;
+};
+
+// State owned by the render thread that the UI shows, copied out after each frame it draws
+struct FrameFeedback {
+	uint64_t frameIndex = 0;
+
+	bool hasModel = false;
+	DrawStats drawStats;
+	bool hasOptimizationReport = false;
+	OptimizationReport optimizationReport;
+	size_t geometryBytes = 0;
+	size_t cpuGeometryBytes = 0;
+	size_t sourceMeshCount = 0;
+	size_t meshCount = 0;
+	std::vector<MeshLodFeedback> meshLods;
+	std::vector<LodLevelFeedback> lodLevels;
+
+	bool loaderBusy = false;
+	float loaderProgress = 0.f;
+	// Always one of ModelLoader's static stage names
+	const char* loaderStage = "Idle";
+	double lastSliceMilliseconds = 0.0;
+	double maxSliceMilliseconds = 0.0;
+	size_t lastSliceBytes = 0;
+
+	SceneGeometryStats geometryStats;
+	RingBufferStats ringStats;
+	GpuResourceTypeStats resourceStats[static_cast<uint32_t>(GpuResourceType::Count)];
+	GLStateStats stateStats;
+};
@@ -0,0 +1,277 @@
+#include "GLState.h"
+#include "glad/glad.h"
+
+#include <iostream>
+
+namespace {
+	GLenum ToGL(DepthFunction function) {
+		switch (function) {
+		case DepthFunction::LessEqual:
+			return GL_LEQUAL;
+		case DepthFunction::Equal:
+			return GL_EQUAL;
+		case DepthFunction::Always:
+			return GL_ALWAYS;
+		default:
+			return GL_LESS;
+		}
+	}
+
+	void Count(GLCallCounts& counts, bool issued) {
+		counts.requested++;
+		if (issued) {
+			counts.issued++;
+		}
+	}
+}
+
+bool PipelineDesc::operator==(const PipelineDesc& other) const {
+	return program == other.program && cull == other.cull && depthTest == other.depthTest && depthWrite == other.depthWrite
+		&& depthFunction == other.depthFunction && blend == other.blend;
+}
+
+GLStateCache& GLStateCache::Instance() {
+	static GLStateCache cache;
+	return cache;
+}
+
+GLStateCache::GLStateCache() {
+	Invalidate();
+}
+
+template <typename SetFunction>
+void GLStateCache::SetState(uint32_t& state, uint32_t value, SetFunction set) {
+	bool issue = state != value;
+	Count(frameStats.fixedFunction, issue);
+	if (issue) {
+		set(value);
+		state = value;
+	}
+}
+
+const Pipeline& GLStateCache::CreatePipeline(const PipelineDesc& desc) {
+	for (const Pipeline& pipeline : pipelines) {
+		if (pipeline.desc == desc) {
+			return pipeline;
+		}
+	}
+	pipelines.push_back(Pipeline(desc));
+	return pipelines.back();
+}
+
+void GLStateCache::SetPipeline(const Pipeline& pipeline) {
+	if (currentPipeline == &pipeline) {
+		return;
+	}
+	currentPipeline = &pipeline;
+	frameStats.pipelineSwitches++;
+
+	const PipelineDesc& desc = pipeline.desc;
+	UseProgram(desc.program);
+
+	SetState(cullEnabled, desc.cull != CullMode::None, [](uint32_t enabled) {
+		enabled ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+	});
+	if (desc.cull != CullMode::None) {
+		SetState(cullFace, desc.cull == CullMode::Front ? GL_FRONT : GL_BACK, [](uint32_t face) {
+			glCullFace(face);
+		});
+	}
+
+	SetState(depthTestEnabled, desc.depthTest, [](uint32_t enabled) {
+		enabled ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+	});
+	SetState(depthWriteEnabled, desc.depthWrite, [](uint32_t enabled) {
+		glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+	});
+	if (desc.depthTest) {
+		SetState(depthFunction, ToGL(desc.depthFunction), [](uint32_t function) {
+			glDepthFunc(function);
+		});
+	}
+
+	SetState(blendEnabled, desc.blend != BlendMode::Opaque, [](uint32_t enabled) {
+		enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+	});
+	if (desc.blend != BlendMode::Opaque) {
+		SetState(blendMode, static_cast<uint32_t>(desc.blend), [](uint32_t mode) {
+			if (static_cast<BlendMode>(mode) == BlendMode::Additive) {
+				glBlendFunc(GL_ONE, GL_ONE);
+			}
+			else {
+				glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			}
+		});
+	}
+}
+
+void GLStateCache::UseProgram(uint32_t newProgram) {
+	bool issue = program != newProgram;
+	Count(frameStats.programs, issue);
+	if (issue) {
+		glUseProgram(newProgram);
+		program = newProgram;
+		// Only a pipeline knows the whole state, so a bare program change leaves none current
+		if (currentPipeline != nullptr && currentPipeline->desc.program != newProgram) {
+			currentPipeline = nullptr;
+		}
+	}
+}
+
+void GLStateCache::BindVertexArray(uint32_t newVertexArray) {
+	bool issue = vertexArray != newVertexArray;
+	Count(frameStats.vertexArrays, issue);
+	if (issue) {
+		glBindVertexArray(newVertexArray);
+		vertexArray = newVertexArray;
+	}
+}
+
+void GLStateCache::BindTexture(uint32_t unit, uint32_t texture) {
+	if (unit >= MAX_TEXTURE_UNITS) {
+		std::cout << "ERROR: Texture unit " << unit << " is beyond the state cache\n";
+		glBindTextureUnit(unit, texture);
+		return;
+	}
+
+	bool issue = textures[unit] != texture;
+	Count(frameStats.textures, issue);
+	if (issue) {
+		glBindTextureUnit(unit, texture);
+		textures[unit] = texture;
+	}
+}
+
+void GLStateCache::BindBuffer(uint32_t target, uint32_t buffer) {
+	uint32_t slot = GetTargetSlot(target);
+	if (slot == UNKNOWN) {
+		glBindBuffer(target, buffer);
+		return;
+	}
+
+	bool issue = buffers[slot] != buffer;
+	Count(frameStats.buffers, issue);
+	if (issue) {
+		glBindBuffer(target, buffer);
+		buffers[slot] = buffer;
+	}
+}
+
+void GLStateCache::BindBufferBase(uint32_t target, uint32_t index, uint32_t buffer) {
+	IndexedBinding* binding = GetIndexedBinding(target, index);
+	if (binding == nullptr) {
+		glBindBufferBase(target, index, buffer);
+		return;
+	}
+
+	// A zero size marks a whole-buffer binding
+	bool issue = binding->buffer != buffer || binding->size != 0;
+	Count(frameStats.buffers, issue);
+	if (issue) {
+		glBindBufferBase(target, index, buffer);
+		*binding = IndexedBinding{ buffer, 0, 0 };
+		buffers[GetTargetSlot(target)] = buffer;
+	}
+}
+
+void GLStateCache::BindBufferRange(uint32_t target, uint32_t index, uint32_t buffer, size_t offset, size_t size) {
+	IndexedBinding* binding = GetIndexedBinding(target, index);
+	if (binding == nullptr) {
+		glBindBufferRange(target, index, buffer, offset, size);
+		return;
+	}
+
+	bool issue = binding->buffer != buffer || binding->offset != offset || binding->size != size;
+	Count(frameStats.buffers, issue);
+	if (issue) {
+		glBindBufferRange(target, index, buffer, offset, size);
+		*binding = IndexedBinding{ buffer, offset, size };
+		buffers[GetTargetSlot(target)] = buffer;
+	}
+}
+
+void GLStateCache::Invalidate() {
+	currentPipeline = nullptr;
+	program = UNKNOWN;
+	vertexArray = UNKNOWN;
+	for (uint32_t& texture : textures) {
+		texture = UNKNOWN;
+	}
+	for (uint32_t& buffer : buffers) {
+		buffer = UNKNOWN;
+	}
+	for (uint32_t i = 0; i < MAX_BUFFER_BINDINGS; i++) {
+		storageBindings[i] = IndexedBinding();
+		uniformBindings[i] = IndexedBinding();
+	}
+	cullEnabled = UNKNOWN;
+	cullFace = UNKNOWN;
+	depthTestEnabled = UNKNOWN;
+	depthWriteEnabled = UNKNOWN;
+	depthFunction = UNKNOWN;
+	blendEnabled = UNKNOWN;
+	blendMode = UNKNOWN;
+}
+
+void GLStateCache::ForgetTexture(uint32_t texture) {
+	for (uint32_t& bound : textures) {
+		if (bound == texture) {
+			bound = UNKNOWN;
+		}
+	}
+}
+
+void GLStateCache::ForgetBuffer(uint32_t buffer) {
+	for (uint32_t& bound : buffers) {
+		if (bound == buffer) {
+			bound = UNKNOWN;
+		}
+	}
+	for (uint32_t i = 0; i < MAX_BUFFER_BINDINGS; i++) {
+		if (storageBindings[i].buffer == buffer) {
+			storageBindings[i] = IndexedBinding();
+		}
+		if (uniformBindings[i].buffer == buffer) {
+			uniformBindings[i] = IndexedBinding();
+		}
+	}
+}
+
+void GLStateCache::ForgetVertexArray(uint32_t deletedVertexArray) {
+	if (vertexArray == deletedVertexArray) {
+		vertexArray = UNKNOWN;
+	}
+}
+
+void GLStateCache::BeginFrame() {
+	lastFrameStats = frameStats;
+	frameStats = GLStateStats();
+}
+
+uint32_t GLStateCache::GetTargetSlot(uint32_t target) {
+	switch (target) {
+	case GL_ARRAY_BUFFER:
+		return static_cast<uint32_t>(BufferTarget::Array);
+	case GL_DRAW_INDIRECT_BUFFER:
+		return static_cast<uint32_t>(BufferTarget::DrawIndirect);
+	case GL_SHADER_STORAGE_BUFFER:
+		return static_cast<uint32_t>(BufferTarget::ShaderStorage);
+	case GL_UNIFORM_BUFFER:
+		return static_cast<uint32_t>(BufferTarget::Uniform);
+	default:
+		return UNKNOWN;
+	}
+}
+
+GLStateCache::IndexedBinding* GLStateCache::GetIndexedBinding(uint32_t target, uint32_t index) {
+	if (index >= MAX_BUFFER_BINDINGS) {
+		return nullptr;
+	}
+	if (target == GL_SHADER_STORAGE_BUFFER) {
+		return &storageBindings[index];
+	}
+	if (target == GL_UNIFORM_BUFFER) {
+		return &uniformBindings[index];
+	}
+	return nullptr;
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+
+enum class CullMode : uint8_t {
+	None,
+	Back,
+	Front
+};
+
+enum class DepthFunction : uint8_t {
+	Less,
+	LessEqual,
+	Equal,
+	Always
+};
+
+enum class BlendMode : uint8_t {
+	Opaque,
+	// Source alpha over destination
+	Alpha,
+	Additive
+};
+
+// Fixed-function state and program that a draw needs, compared field by field when applied
+struct PipelineDesc {
+	uint32_t program = 0;
+	CullMode cull = CullMode::Back;
+	bool depthTest = true;
+	bool depthWrite = true;
+	DepthFunction depthFunction = DepthFunction::Less;
+	BlendMode blend = BlendMode::Opaque;
+
+	bool operator==(const PipelineDesc& other) const;
+};
+
+// Immutable once created; obtained from GLStateCache::CreatePipeline and valid until shutdown
+class Pipeline {
+public:
+	const PipelineDesc& GetDesc() const { return desc; }
+
+private:
+	friend class GLStateCache;
+
+	explicit Pipeline(const PipelineDesc& desc) : desc(desc) {}
+
+	PipelineDesc desc;
+};
+
+// Requested and actually issued calls of one kind; the difference is what the cache saved
+struct GLCallCounts {
+	uint64_t requested = 0;
+	uint64_t issued = 0;
+
+	uint64_t GetElided() const { return requested - issued; }
+};
+
+struct GLStateStats {
+	GLCallCounts programs;
+	GLCallCounts vertexArrays;
+	GLCallCounts textures;
+	GLCallCounts buffers;
+	// Enables, depth, cull and blend settings changed through pipelines
+	GLCallCounts fixedFunction;
+	uint32_t pipelineSwitches = 0;
+};
+
+// Shadows the main context's binding and fixed-function state so redundant calls are never issued.
+// Everything on the main context that binds a program, vertex array, texture unit or buffer goes
+// through here, otherwise the shadow goes stale; call Invalidate after code that does not.
+// GL thread only; the upload context has its own state and does not use it.
+class GLStateCache {
+public:
+	static constexpr uint32_t MAX_TEXTURE_UNITS = 32;
+	static constexpr uint32_t MAX_BUFFER_BINDINGS = 16;
+
+	static GLStateCache& Instance();
+
+	// Returns the pipeline with this description, creating it on first use
+	const Pipeline& CreatePipeline(const PipelineDesc& desc);
+
+	// Applies only the parts of pipeline that differ from the current state
+	void SetPipeline(const Pipeline& pipeline);
+
+	void UseProgram(uint32_t program);
+
+	void BindVertexArray(uint32_t vertexArray);
+
+	void BindTexture(uint32_t unit, uint32_t texture);
+
+	// Non-indexed targets only, such as GL_DRAW_INDIRECT_BUFFER or GL_ARRAY_BUFFER; element buffers belong to vertex arrays
+	void BindBuffer(uint32_t target, uint32_t buffer);
+
+	// GL_UNIFORM_BUFFER and GL_SHADER_STORAGE_BUFFER bindings; also sets the target's generic binding as GL does
+	void BindBufferBase(uint32_t target, uint32_t index, uint32_t buffer);
+
+	void BindBufferRange(uint32_t target, uint32_t index, uint32_t buffer, size_t offset, size_t size);
+
+	// Forgets everything, so the next call of each kind is issued
+	void Invalidate();
+
+	// Called when an object is deleted, since GL unbinds it and may hand its name to a new object
+	void ForgetTexture(uint32_t texture);
+
+	void ForgetBuffer(uint32_t buffer);
+
+	void ForgetVertexArray(uint32_t deletedVertexArray);
+
+	// Called once per frame; GetLastFrameStats then reports the frame just finished
+	void BeginFrame();
+
+	const GLStateStats& GetLastFrameStats() const { return lastFrameStats; }
+
+private:
+	static constexpr uint32_t UNKNOWN = UINT32_MAX;
+
+	enum class BufferTarget : uint32_t {
+		Array,
+		DrawIndirect,
+		ShaderStorage,
+		Uniform,
+		Count
+	};
+
+	struct IndexedBinding {
+		uint32_t buffer = UNKNOWN;
+		size_t offset = 0;
+		size_t size = 0;
+	};
+
+	GLStateCache();
+
+	std::deque<Pipeline> pipelines;
+	const Pipeline* currentPipeline = nullptr;
+
+	uint32_t program = UNKNOWN;
+	uint32_t vertexArray = UNKNOWN;
+	uint32_t textures[MAX_TEXTURE_UNITS];
+	uint32_t buffers[static_cast<size_t>(BufferTarget::Count)];
+	IndexedBinding storageBindings[MAX_BUFFER_BINDINGS];
+	IndexedBinding uniformBindings[MAX_BUFFER_BINDINGS];
+
+	// 0 or 1, or UNKNOWN until first set
+	uint32_t cullEnabled = UNKNOWN;
+	uint32_t cullFace = UNKNOWN;
+	uint32_t depthTestEnabled = UNKNOWN;
+	uint32_t depthWriteEnabled = UNKNOWN;
+	uint32_t depthFunction = UNKNOWN;
+	uint32_t blendEnabled = UNKNOWN;
+	uint32_t blendMode = UNKNOWN;
+
+	GLStateStats frameStats;
+	GLStateStats lastFrameStats;
+
+	static uint32_t GetTargetSlot(uint32_t target);
+
+	IndexedBinding* GetIndexedBinding(uint32_t target, uint32_t index);
+
+	// Issues set(value) unless state already holds value
+	template <typename SetFunction>
+	void SetState(uint32_t& state, uint32_t value, SetFunction set);
+};
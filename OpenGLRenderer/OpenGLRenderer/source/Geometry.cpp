@@ -1,5 +1,24 @@
-#include "glad/glad.h"
+#include "VertexLayout.h"
 #include "Geometry.h"
+#include "GLState.h"
+
+namespace {
+	// Rows of the vertex arrays below: position then texture coordinates
+	struct TexturedVertex {
+		glm::vec3 position;
+		glm::vec2 texCoords;
+	};
+
+	struct TexturedVertexLayout {
+		using VertexType = TexturedVertex;
+		static constexpr std::array<VertexAttribute, 2> ATTRIBUTES = { {
+			MakeAttribute<glm::vec3>(0, offsetof(TexturedVertex, position)),
+			MakeAttribute<glm::vec2>(1, offsetof(TexturedVertex, texCoords)),
+		} };
+	};
+
+	static_assert(sizeof(TexturedVertex) == 5 * sizeof(float), "TexturedVertex no longer matches the vertex arrays");
+}
 
 uint32_t GetCubeVAO() {
 	float vertices[] = {
@@ -48,18 +67,14 @@ uint32_t GetCubeVAO() {
 
 	uint32_t VAO;
 	glGenVertexArrays(1, &VAO);
-	glBindVertexArray(VAO);
+	GLStateCache::Instance().BindVertexArray(VAO);
 
 	uint32_t VBO;
 	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
+	GLStateCache::Instance().BindBuffer(GL_ARRAY_BUFFER, VBO);
+	size_t vertexCount = sizeof(vertices) / (sizeof(TexturedVertex));
+	UploadVertices<Interleaved<TexturedVertexLayout>>(reinterpret_cast<const TexturedVertex*>(vertices), vertexCount);
+	SetupVertexAttributes<Interleaved<TexturedVertexLayout>>(vertexCount);
 
 	return VAO;
 }
@@ -111,18 +126,14 @@ uint32_t GetContainerVAO() {
 
 	uint32_t VAO;
 	glGenVertexArrays(1, &VAO);
-	glBindVertexArray(VAO);
+	GLStateCache::Instance().BindVertexArray(VAO);
 
 	uint32_t VBO;
 	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
+	GLStateCache::Instance().BindBuffer(GL_ARRAY_BUFFER, VBO);
+	size_t vertexCount = sizeof(vertices) / (sizeof(TexturedVertex));
+	UploadVertices<Interleaved<TexturedVertexLayout>>(reinterpret_cast<const TexturedVertex*>(vertices), vertexCount);
+	SetupVertexAttributes<Interleaved<TexturedVertexLayout>>(vertexCount);
 
 	return VAO;
 }
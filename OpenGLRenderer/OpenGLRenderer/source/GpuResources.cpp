@@ -0,0 +1,232 @@
+#include "GpuResources.h"
+#include "glad/glad.h"
+#include "GLState.h"
+
+#include <algorithm>
+#include <utility>
+#include <iostream>
+
+GpuResourceRegistry& GpuResourceRegistry::Instance() {
+	static GpuResourceRegistry registry;
+	return registry;
+}
+
+GpuResourceHandle GpuResourceRegistry::Register(GpuResourceType type, uint32_t name, size_t bytes) {
+	if (name == 0) {
+		return GpuResourceHandle();
+	}
+
+	uint32_t index;
+	if (!freeSlots.empty()) {
+		index = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		index = static_cast<uint32_t>(slots.size());
+		slots.emplace_back();
+	}
+
+	Slot& slot = slots[index];
+	slot.type = type;
+	slot.name = name;
+	slot.referenceCount = 1;
+	slot.bytes = bytes;
+
+	GpuResourceTypeStats& typeStats = stats[static_cast<uint32_t>(type)];
+	typeStats.live++;
+	typeStats.liveBytes += bytes;
+	typeStats.created++;
+	return GpuResourceHandle{ index, slot.generation };
+}
+
+void GpuResourceRegistry::AddReference(GpuResourceHandle handle) {
+	Slot* slot = Find(handle);
+	if (slot != nullptr) {
+		slot->referenceCount++;
+	}
+}
+
+void GpuResourceRegistry::Release(GpuResourceHandle handle) {
+	Slot* slot = Find(handle);
+	if (slot == nullptr || --slot->referenceCount > 0) {
+		return;
+	}
+
+	GpuResourceTypeStats& typeStats = stats[static_cast<uint32_t>(slot->type)];
+	typeStats.live--;
+	typeStats.liveBytes -= slot->bytes;
+	typeStats.pendingDeletes++;
+	typeStats.pendingBytes += slot->bytes;
+	pendingDeletes.push_back(PendingDelete{ slot->type, slot->name, slot->bytes, frameSerial });
+
+	// Outstanding copies of the handle now resolve to nothing, even after the slot is reused
+	slot->name = 0;
+	slot->bytes = 0;
+	slot->generation = slot->generation == UINT32_MAX ? 1 : slot->generation + 1;
+	freeSlots.push_back(handle.index);
+}
+
+void GpuResourceRegistry::ReleaseDeferred(GpuResourceType type, uint32_t name, size_t bytes) {
+	if (name == 0 || shutDown) {
+		return;
+	}
+
+	GpuResourceTypeStats& typeStats = stats[static_cast<uint32_t>(type)];
+	typeStats.created++;
+	typeStats.pendingDeletes++;
+	typeStats.pendingBytes += bytes;
+	pendingDeletes.push_back(PendingDelete{ type, name, bytes, frameSerial });
+}
+
+uint32_t GpuResourceRegistry::GetName(GpuResourceHandle handle) const {
+	if (handle.index >= slots.size() || slots[handle.index].generation != handle.generation) {
+		return 0;
+	}
+	return slots[handle.index].name;
+}
+
+void GpuResourceRegistry::SetBytes(GpuResourceHandle handle, size_t bytes) {
+	Slot* slot = Find(handle);
+	if (slot == nullptr) {
+		return;
+	}
+
+	GpuResourceTypeStats& typeStats = stats[static_cast<uint32_t>(slot->type)];
+	typeStats.liveBytes = typeStats.liveBytes - slot->bytes + bytes;
+	slot->bytes = bytes;
+}
+
+void GpuResourceRegistry::Update() {
+	// Everything submitted so far belongs to frameSerial
+	frameFences.push_back(FrameFence{ frameSerial, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+	frameSerial++;
+
+	while (!frameFences.empty()) {
+		GLsync sync = static_cast<GLsync>(frameFences.front().sync);
+		GLenum result = glClientWaitSync(sync, 0, 0);
+		if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+			break;
+		}
+		completedSerial = frameFences.front().serial;
+		glDeleteSync(sync);
+		frameFences.pop_front();
+	}
+
+	auto deleted = std::remove_if(pendingDeletes.begin(), pendingDeletes.end(), [&](const PendingDelete& pending) {
+		if (pending.frameSerial > completedSerial) {
+			return false;
+		}
+		Delete(pending.type, pending.name);
+		GpuResourceTypeStats& typeStats = stats[static_cast<uint32_t>(pending.type)];
+		typeStats.pendingDeletes--;
+		typeStats.pendingBytes -= pending.bytes;
+		typeStats.deleted++;
+		return true;
+	});
+	pendingDeletes.erase(deleted, pendingDeletes.end());
+}
+
+void GpuResourceRegistry::Shutdown() {
+	for (const PendingDelete& pending : pendingDeletes) {
+		Delete(pending.type, pending.name);
+	}
+	pendingDeletes.clear();
+
+	uint32_t leaked = 0;
+	for (Slot& slot : slots) {
+		if (slot.name != 0) {
+			Delete(slot.type, slot.name);
+			slot.name = 0;
+			slot.generation++;
+			leaked++;
+		}
+	}
+	if (leaked > 0) {
+		std::cout << "ERROR: " << leaked << " GPU objects were still referenced at shutdown\n";
+	}
+
+	for (const FrameFence& fence : frameFences) {
+		glDeleteSync(static_cast<GLsync>(fence.sync));
+	}
+	frameFences.clear();
+
+	for (GpuResourceTypeStats& typeStats : stats) {
+		typeStats = GpuResourceTypeStats();
+	}
+	// References still held (e.g. by statics) are dropped without GL calls from now on
+	shutDown = true;
+}
+
+GpuResourceRegistry::Slot* GpuResourceRegistry::Find(GpuResourceHandle handle) {
+	if (shutDown || handle.index >= slots.size() || slots[handle.index].generation != handle.generation || slots[handle.index].name == 0) {
+		return nullptr;
+	}
+	return &slots[handle.index];
+}
+
+void GpuResourceRegistry::Delete(GpuResourceType type, uint32_t name) {
+	// Deleting unbinds the object and frees its name for reuse, so the state cache must not still think it bound
+	switch (type) {
+	case GpuResourceType::Texture:
+		glDeleteTextures(1, &name);
+		GLStateCache::Instance().ForgetTexture(name);
+		break;
+	case GpuResourceType::Buffer:
+		glDeleteBuffers(1, &name);
+		GLStateCache::Instance().ForgetBuffer(name);
+		break;
+	case GpuResourceType::VertexArray:
+		glDeleteVertexArrays(1, &name);
+		GLStateCache::Instance().ForgetVertexArray(name);
+		break;
+	default:
+		break;
+	}
+}
+
+GpuResource::GpuResource(GpuResourceType type, uint32_t name, size_t bytes) {
+	handle = GpuResourceRegistry::Instance().Register(type, name, bytes);
+}
+
+GpuResource::~GpuResource() {
+	Reset();
+}
+
+GpuResource::GpuResource(const GpuResource& other) : handle(other.handle) {
+	GpuResourceRegistry::Instance().AddReference(handle);
+}
+
+GpuResource& GpuResource::operator=(const GpuResource& other) {
+	if (this != &other) {
+		GpuResourceRegistry::Instance().AddReference(other.handle);
+		Reset();
+		handle = other.handle;
+	}
+	return *this;
+}
+
+GpuResource::GpuResource(GpuResource&& other) noexcept : handle(std::exchange(other.handle, GpuResourceHandle())) {
+}
+
+GpuResource& GpuResource::operator=(GpuResource&& other) noexcept {
+	if (this != &other) {
+		Reset();
+		handle = std::exchange(other.handle, GpuResourceHandle());
+	}
+	return *this;
+}
+
+uint32_t GpuResource::GetName() const {
+	return GpuResourceRegistry::Instance().GetName(handle);
+}
+
+void GpuResource::SetBytes(size_t bytes) {
+	GpuResourceRegistry::Instance().SetBytes(handle, bytes);
+}
+
+void GpuResource::Reset() {
+	if (handle.IsValid()) {
+		GpuResourceRegistry::Instance().Release(handle);
+		handle = GpuResourceHandle();
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <cstddef>
+
+enum class GpuResourceType : uint32_t {
+	Texture,
+	Buffer,
+	VertexArray,
+	Count
+};
+
+// Slot index plus the generation it was issued for, so handles to deleted objects are detected instead of reused
+struct GpuResourceHandle {
+	uint32_t index = 0;
+	uint32_t generation = 0;
+
+	bool IsValid() const { return generation != 0; }
+};
+
+struct GpuResourceTypeStats {
+	uint32_t live = 0;
+	size_t liveBytes = 0;
+	// Unreferenced, waiting for the GPU to finish the frame that last could have used them
+	uint32_t pendingDeletes = 0;
+	size_t pendingBytes = 0;
+	uint64_t created = 0;
+	uint64_t deleted = 0;
+};
+
+// Owns every registered GL object by reference count. The last release queues the object and
+// it is only deleted once a fence shows the GPU has finished the frame it was released in.
+// Also keeps the per-frame fences other systems use to defer reuse of GPU memory. GL thread only.
+class GpuResourceRegistry {
+public:
+	static GpuResourceRegistry& Instance();
+
+	// Takes ownership of a GL object name with one reference
+	GpuResourceHandle Register(GpuResourceType type, uint32_t name, size_t bytes);
+
+	void AddReference(GpuResourceHandle handle);
+
+	void Release(GpuResourceHandle handle);
+
+	// Takes ownership of a GL object name that was never registered and queues its delete straight away,
+	// for objects whose last use is a command just submitted, e.g. the source of a copy
+	void ReleaseDeferred(GpuResourceType type, uint32_t name, size_t bytes);
+
+	// The GL name, or 0 for a handle whose object has been released
+	uint32_t GetName(GpuResourceHandle handle) const;
+
+	// For objects whose storage is respecified after creation
+	void SetBytes(GpuResourceHandle handle, size_t bytes);
+
+	// Called once per frame before drawing: fences the previous frame and deletes what the GPU is done with
+	void Update();
+
+	// Serial of the frame being recorded; anything released now is safe once GetCompletedSerial reaches it
+	uint64_t GetFrameSerial() const { return frameSerial; }
+
+	uint64_t GetCompletedSerial() const { return completedSerial; }
+
+	const GpuResourceTypeStats& GetStats(GpuResourceType type) const { return stats[static_cast<uint32_t>(type)]; }
+
+	// Deletes every object, referenced or not; called before the context goes away
+	void Shutdown();
+
+private:
+	struct Slot {
+		GpuResourceType type = GpuResourceType::Texture;
+		uint32_t name = 0;
+		uint32_t referenceCount = 0;
+		uint32_t generation = 1;
+		size_t bytes = 0;
+	};
+
+	struct PendingDelete {
+		GpuResourceType type;
+		uint32_t name;
+		size_t bytes;
+		uint64_t frameSerial;
+	};
+
+	struct FrameFence {
+		uint64_t serial;
+		void* sync;
+	};
+
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots;
+	std::vector<PendingDelete> pendingDeletes;
+	GpuResourceTypeStats stats[static_cast<uint32_t>(GpuResourceType::Count)];
+
+	uint64_t frameSerial = 1;
+	uint64_t completedSerial = 0;
+	std::deque<FrameFence> frameFences;
+	bool shutDown = false;
+
+	Slot* Find(GpuResourceHandle handle);
+
+	static void Delete(GpuResourceType type, uint32_t name);
+};
+
+// Counted reference to one registered GL object; copies share it and the last one to go schedules the delete
+class GpuResource {
+public:
+	GpuResource() = default;
+
+	GpuResource(GpuResourceType type, uint32_t name, size_t bytes);
+
+	~GpuResource();
+
+	GpuResource(const GpuResource& other);
+	GpuResource& operator=(const GpuResource& other);
+
+	GpuResource(GpuResource&& other) noexcept;
+	GpuResource& operator=(GpuResource&& other) noexcept;
+
+	uint32_t GetName() const;
+
+	void SetBytes(size_t bytes);
+
+	// Drops this reference early
+	void Reset();
+
+private:
+	GpuResourceHandle handle;
+};
@@ -0,0 +1,77 @@
+#include "LodScaleCheck.h"
+#include "MeshSimplifier.h"
+
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+	constexpr uint32_t SPHERE_RINGS = 64;
+	constexpr uint32_t SPHERE_SEGMENTS = 64;
+	// Powers of two scale every position exactly, so the levels must match to the last bit. At other scales
+	// rounding breaks ties between the sphere's many equal-cost collapses differently, which changes deeper levels.
+	constexpr float SCALES[] = { 1.f / 128.f, 1.f, 128.f };
+	constexpr float RELATIVE_TOLERANCE = 0.001f;
+
+	// UV sphere with a duplicated seam column, so the simplifier also sees wedges with split UVs
+	MeshData BuildSphere(float radius) {
+		MeshData mesh;
+		const float pi = 3.14159265358979f;
+		for (uint32_t ring = 0; ring <= SPHERE_RINGS; ring++) {
+			float theta = pi * ring / SPHERE_RINGS;
+			for (uint32_t segment = 0; segment <= SPHERE_SEGMENTS; segment++) {
+				float phi = 2.f * pi * segment / SPHERE_SEGMENTS;
+				glm::vec3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+				mesh.vertices.push_back(Vertex{ normal * radius, normal,
+					glm::vec2(static_cast<float>(segment) / SPHERE_SEGMENTS, static_cast<float>(ring) / SPHERE_RINGS) });
+			}
+		}
+
+		for (uint32_t ring = 0; ring < SPHERE_RINGS; ring++) {
+			for (uint32_t segment = 0; segment < SPHERE_SEGMENTS; segment++) {
+				uint32_t a = ring * (SPHERE_SEGMENTS + 1) + segment;
+				uint32_t b = a + SPHERE_SEGMENTS + 1;
+				mesh.indices.insert(mesh.indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+			}
+		}
+		return mesh;
+	}
+}
+
+bool RunLodScaleCheck() {
+	LodSettings settings;
+	std::vector<MeshLod> reference;
+	bool passed = true;
+
+	for (float scale : SCALES) {
+		MeshData mesh = BuildSphere(scale);
+		MeshSimplifier::GenerateLods(mesh, settings, false);
+
+		std::cout << "Scale " << std::setw(6) << scale << ":";
+		for (const MeshLod& lod : mesh.lods) {
+			std::cout << "  " << lod.indexCount / 3 << " tris, error " << std::setprecision(4) << lod.error;
+		}
+		std::cout << "\n";
+
+		if (reference.empty()) {
+			reference = mesh.lods;
+			continue;
+		}
+		if (mesh.lods.size() != reference.size()) {
+			passed = false;
+			continue;
+		}
+		for (size_t level = 0; level < mesh.lods.size(); level++) {
+			float triangleDifference = std::abs(static_cast<float>(mesh.lods[level].indexCount) - reference[level].indexCount);
+			float errorDifference = std::abs(mesh.lods[level].error - reference[level].error);
+			if (triangleDifference > RELATIVE_TOLERANCE * reference[level].indexCount
+				|| errorDifference > RELATIVE_TOLERANCE * std::max(reference[level].error, settings.maxRelativeError * RELATIVE_TOLERANCE)) {
+				passed = false;
+			}
+		}
+	}
+
+	std::cout << (passed ? "LOD errors are independent of scale\n" : "ERROR: LOD levels differ between scales\n");
+	return passed;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// Generates levels of detail for one sphere at several uniform scales and checks that every level
+// has the same triangle count and relative error at each scale. Prints the levels; returns false on a mismatch.
+bool RunLodScaleCheck();
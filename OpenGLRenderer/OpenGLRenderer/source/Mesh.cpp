@@ -1,49 +1,330 @@
 #include "Mesh.h"
 #include "glad/glad.h"
+#include "GLState.h"
 
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices, std::vector<Texture> textures) {
-	this->vertices = vertices;
-	this->indices = indices;
-	this->textures = textures;
+#include <vector>
+#include <utility>
+#include <iostream>
 
-	SetupMesh();
+void FinalizeMeshData(MeshData& mesh) {
+	if (mesh.lods.empty()) {
+		mesh.lods.push_back(MeshLod{ 0, static_cast<uint32_t>(mesh.indices.size()), 0.f });
+	}
+
+	if (mesh.vertices.empty()) {
+		return;
+	}
+
+	glm::vec3 minimum = mesh.vertices[0].Position;
+	glm::vec3 maximum = mesh.vertices[0].Position;
+	for (const Vertex& vertex : mesh.vertices) {
+		minimum = glm::min(minimum, vertex.Position);
+		maximum = glm::max(maximum, vertex.Position);
+	}
+
+	mesh.boundsCenter = 0.5f * (minimum + maximum);
+	mesh.boundsRadius = 0.f;
+	for (const Vertex& vertex : mesh.vertices) {
+		mesh.boundsRadius = glm::max(mesh.boundsRadius, glm::length(vertex.Position - mesh.boundsCenter));
+	}
+}
+
+MeshView GetMeshView(const MeshData& mesh) {
+	MeshView view;
+	view.vertices = mesh.vertices.data();
+	view.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+	view.indices = mesh.indices.data();
+	view.indexCount = static_cast<uint32_t>(mesh.indices.size());
+	view.lods = mesh.lods.data();
+	view.lodCount = static_cast<uint32_t>(mesh.lods.size());
+	view.meshlets = mesh.meshlets.data();
+	view.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+	view.submeshes = mesh.submeshes.data();
+	view.submeshCount = static_cast<uint32_t>(mesh.submeshes.size());
+	view.submeshRanges = mesh.submeshRanges.data();
+	view.boundsCenter = mesh.boundsCenter;
+	view.boundsRadius = mesh.boundsRadius;
+	view.diffuseTextures = mesh.diffuseTextures;
+	return view;
+}
+
+namespace {
+	// Pool-ready form of a mesh's geometry; the pointers refer either to the source or to the vectors held here
+	struct EncodedGeometry {
+		std::vector<CompactVertex> compact;
+		std::vector<uint16_t> narrowIndices;
+		const void* vertices = nullptr;
+		const void* indices = nullptr;
+		bool wideIndices = true;
+		MeshDrawData drawData;
+	};
+
+	EncodedGeometry EncodeGeometry(const Vertex* vertexData, size_t vertexCount, const uint32_t* indexData, size_t indexCount, bool compactVertices) {
+		EncodedGeometry encoded;
+		encoded.vertices = vertexData;
+		if (compactVertices) {
+			PositionDecode decode = VertexQuantization::Quantize(vertexData, vertexCount, encoded.compact);
+			encoded.drawData.positionOffset = glm::vec4(decode.offset, 0.f);
+			encoded.drawData.positionScale = glm::vec4(decode.scale, 0.f);
+			encoded.vertices = encoded.compact.data();
+		}
+
+		// Indices stay relative to the mesh's base vertex, so 16 bits suffice for up to 65536 vertices
+		encoded.wideIndices = !VertexQuantization::NarrowIndices(indexData, indexCount, vertexCount, encoded.narrowIndices);
+		encoded.indices = encoded.wideIndices ? static_cast<const void*>(indexData) : encoded.narrowIndices.data();
+		return encoded;
+	}
+
+	MeshData MakeMeshData(std::vector<Vertex>&& vertices, std::vector<uint32_t>&& indices) {
+		MeshData data;
+		data.vertices = std::move(vertices);
+		data.indices = std::move(indices);
+		FinalizeMeshData(data);
+		return data;
+	}
+}
+
+MeshUniforms MeshUniforms::Resolve(const Shader& shader) {
+	MeshUniforms uniforms;
+	uniforms.compactVertices = shader.GetUniform<bool>("compactVertices");
+	uniforms.vertexPulling = shader.GetUniform<bool>("vertexPulling");
+	return uniforms;
+}
+
+Mesh::Mesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices, std::vector<Texture> textures, CpuGeometryPolicy cpuGeometry)
+	: Mesh(MakeMeshData(std::move(vertices), std::move(indices)), std::move(textures), false, cpuGeometry) {
+}
+
+Mesh::Mesh(const MeshView& view, std::vector<Texture> textures, bool compactVertices, CpuGeometryPolicy cpuGeometry, const StagedGeometry* staged) {
+	this->textures = std::move(textures);
+
+	lods.assign(view.lods, view.lods + view.lodCount);
+	if (lods.empty()) {
+		lods.push_back(MeshLod{ 0, view.indexCount, 0.f });
+	}
+	boundsCenter = view.boundsCenter;
+	boundsRadius = view.boundsRadius;
+	meshlets.assign(view.meshlets, view.meshlets + view.meshletCount);
+	submeshes.assign(view.submeshes, view.submeshes + view.submeshCount);
+	submeshRanges.assign(view.submeshRanges, view.submeshRanges + static_cast<size_t>(view.submeshCount) * view.lodCount);
+
+	SetupMesh(view.vertices, view.vertexCount, view.indices, view.indexCount, compactVertices, staged);
+
+	if (cpuGeometry == CpuGeometryPolicy::Keep) {
+		vertices.assign(view.vertices, view.vertices + view.vertexCount);
+		indices.assign(view.indices, view.indices + view.indexCount);
+	}
+}
+
+Mesh::Mesh(MeshData&& data, std::vector<Texture> textures, bool compactVertices, CpuGeometryPolicy cpuGeometry, const StagedGeometry* staged) {
+	this->textures = std::move(textures);
+
+	lods = std::move(data.lods);
+	if (lods.empty()) {
+		lods.push_back(MeshLod{ 0, static_cast<uint32_t>(data.indices.size()), 0.f });
+	}
+	boundsCenter = data.boundsCenter;
+	boundsRadius = data.boundsRadius;
+	meshlets = std::move(data.meshlets);
+	submeshes = std::move(data.submeshes);
+	submeshRanges = std::move(data.submeshRanges);
+
+	SetupMesh(data.vertices.data(), data.vertices.size(), data.indices.data(), data.indices.size(), compactVertices, staged);
+
+	if (cpuGeometry == CpuGeometryPolicy::Keep) {
+		vertices = std::move(data.vertices);
+		indices = std::move(data.indices);
+	}
+	else {
+		std::vector<Vertex>().swap(data.vertices);
+		std::vector<uint32_t>().swap(data.indices);
+	}
+}
+
+Mesh::Mesh(Mesh&& other) noexcept {
+	Swap(other);
+}
+
+Mesh& Mesh::operator=(Mesh&& other) noexcept {
+	if (this != &other) {
+		Release();
+		Swap(other);
+	}
+	return *this;
 }
 
-void Mesh::Draw(const Shader& shader) {
-	for (int i = 0; i < textures.size(); i++) {
+void Mesh::Swap(Mesh& other) noexcept {
+	std::swap(vertices, other.vertices);
+	std::swap(indices, other.indices);
+	std::swap(textures, other.textures);
+	std::swap(pool, other.pool);
+	std::swap(allocation, other.allocation);
+	std::swap(drawId, other.drawId);
+	std::swap(lods, other.lods);
+	std::swap(boundsCenter, other.boundsCenter);
+	std::swap(boundsRadius, other.boundsRadius);
+	std::swap(meshlets, other.meshlets);
+	std::swap(submeshes, other.submeshes);
+	std::swap(submeshRanges, other.submeshRanges);
+}
+
+void Mesh::Draw(const Shader& shader, const MeshUniforms& uniforms, uint32_t lodIndex) {
+	if (!IsDrawable()) {
+		return;
+	}
+
+	BindMaterial(shader, uniforms);
+	shader.Set(uniforms.vertexPulling, false);
+	SceneGeometry::Instance().BindDrawData();
+
+	const MeshLod& lod = lods[lodIndex];
+	const GeometryRange& range = pool->GetRange(allocation);
+	pool->Bind();
+	glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, lod.indexCount, pool->GetIndexType(),
+		(void*)((static_cast<size_t>(range.firstIndex) + lod.indexOffset) * pool->GetIndexSize()), 1, range.baseVertex, drawId);
+}
+
+void Mesh::AppendDraw(uint32_t lodIndex, std::vector<DrawElementsIndirectCommand>& commands) const {
+	const GeometryRange& range = pool->GetRange(allocation);
+	DrawElementsIndirectCommand command;
+	command.count = lods[lodIndex].indexCount;
+	command.firstIndex = range.firstIndex + lods[lodIndex].indexOffset;
+	command.baseVertex = static_cast<int32_t>(range.baseVertex);
+	command.baseInstance = drawId;
+	commands.push_back(command);
+}
+
+size_t Mesh::AppendMeshletDraws(const MeshletCullData& cullData, MeshletCullStats& stats, std::vector<DrawElementsIndirectCommand>& commands) const {
+	const GeometryRange& range = pool->GetRange(allocation);
+	size_t triangles = 0;
+	uint32_t rangeEnd = UINT32_MAX;
+	for (const Meshlet& meshlet : meshlets) {
+		if (!Meshlets::IsVisible(meshlet, cullData, stats)) {
+			continue;
+		}
+
+		triangles += meshlet.triangleCount;
+		if (meshlet.indexOffset == rangeEnd) {
+			commands.back().count += meshlet.triangleCount * 3;
+		}
+		else {
+			DrawElementsIndirectCommand command;
+			command.count = meshlet.triangleCount * 3;
+			command.firstIndex = range.firstIndex + meshlet.indexOffset;
+			command.baseVertex = static_cast<int32_t>(range.baseVertex);
+			command.baseInstance = drawId;
+			commands.push_back(command);
+		}
+		rangeEnd = meshlet.indexOffset + meshlet.triangleCount * 3;
+	}
+	return triangles;
+}
+
+size_t Mesh::AppendSubmeshDraws(uint32_t lodIndex, const MeshletCullData& cullData, SubmeshCullStats& stats,
+	std::vector<DrawElementsIndirectCommand>& commands) const {
+	const GeometryRange& range = pool->GetRange(allocation);
+	const SubmeshRange* levelRanges = submeshRanges.data() + static_cast<size_t>(lodIndex) * submeshes.size();
+	size_t triangles = 0;
+	uint32_t rangeEnd = UINT32_MAX;
+	for (size_t i = 0; i < submeshes.size(); i++) {
+		stats.tested++;
+		if (!Meshlets::IsSphereInFrustum(submeshes[i].boundsCenter, submeshes[i].boundsRadius, cullData)) {
+			stats.frustumCulled++;
+			continue;
+		}
+
+		const SubmeshRange& submeshRange = levelRanges[i];
+		triangles += submeshRange.indexCount / 3;
+		if (submeshRange.indexOffset == rangeEnd) {
+			commands.back().count += submeshRange.indexCount;
+		}
+		else {
+			DrawElementsIndirectCommand command;
+			command.count = submeshRange.indexCount;
+			command.firstIndex = range.firstIndex + submeshRange.indexOffset;
+			command.baseVertex = static_cast<int32_t>(range.baseVertex);
+			command.baseInstance = drawId;
+			commands.push_back(command);
+		}
+		rangeEnd = submeshRange.indexOffset + submeshRange.indexCount;
+	}
+	return triangles;
+}
+
+void Mesh::Release() {
+	if (pool != nullptr) {
+		SceneGeometry::Instance().Release(*pool, allocation, drawId);
+		pool = nullptr;
+	}
+}
+
+void Mesh::BindMaterial(const Shader& shader, const MeshUniforms& uniforms) {
+	for (uint32_t i = 0; i < textures.size(); i++) {
 		textures[i].Activate(i);
 	}
 
-	glBindVertexArray(VAO);
-	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
-
-	glActiveTexture(GL_TEXTURE0);
-}
-
-void Mesh::SetupMesh() {
-	glGenVertexArrays(1, &VAO);
-	
-	// Vertex data
-	glBindVertexArray(VAO);
-	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-	
-	// Index Data
-	glGenBuffers(1, &EBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), &indices[0], GL_STATIC_DRAW);
-	
-	// Vertex Position
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(Vertex), (void*)0);
-	// Vertex Normal
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-	// Vertex TexCoords
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-
-	glBindVertexArray(0);
+	shader.Set(uniforms.compactVertices, pool->HasCompactVertices());
+}
+
+void Mesh::RecordMaterial(CommandList& commandList, const Shader& shader, const MeshUniforms& uniforms) const {
+	for (uint32_t i = 0; i < textures.size(); i++) {
+		commandList.BindTexture(i, textures[i].GetId());
+	}
+
+	commandList.SetUniform(shader.GetId(), uniforms.compactVertices.location, pool->HasCompactVertices());
+}
+
+StagedGeometry Mesh::Stage(const MeshView& view, bool compactVertices) {
+	EncodedGeometry encoded = EncodeGeometry(view.vertices, view.vertexCount, view.indices, view.indexCount, compactVertices);
+
+	StagedGeometry staged;
+	staged.vertexCount = view.vertexCount;
+	staged.indexCount = view.indexCount;
+	staged.compactVertices = compactVertices;
+	staged.wideIndices = encoded.wideIndices;
+	staged.drawData = encoded.drawData;
+
+	size_t vertexBytes = static_cast<size_t>(view.vertexCount) * (compactVertices ? sizeof(CompactVertex) : sizeof(Vertex));
+	size_t indexBytes = static_cast<size_t>(view.indexCount) * (encoded.wideIndices ? sizeof(uint32_t) : sizeof(uint16_t));
+	// Copy sources need no particular alignment, but keeping indices on 4 bytes is cheap
+	staged.indexByteOffset = (vertexBytes + 3) & ~static_cast<size_t>(3);
+	staged.bytes = staged.indexByteOffset + indexBytes;
+	if (staged.bytes == 0) {
+		return staged;
+	}
+
+	glCreateBuffers(1, &staged.buffer);
+	glNamedBufferStorage(staged.buffer, static_cast<GLsizeiptr>(staged.bytes), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	glNamedBufferSubData(staged.buffer, 0, static_cast<GLsizeiptr>(vertexBytes), encoded.vertices);
+	glNamedBufferSubData(staged.buffer, static_cast<GLintptr>(staged.indexByteOffset), static_cast<GLsizeiptr>(indexBytes), encoded.indices);
+	return staged;
+}
+
+void Mesh::DiscardStaged(StagedGeometry& staged) {
+	if (staged.buffer != 0) {
+		glDeleteBuffers(1, &staged.buffer);
+		staged.buffer = 0;
+	}
+}
+
+void Mesh::SetupMesh(const Vertex* vertexData, size_t vertexCount, const uint32_t* indexData, size_t indexCount, bool compactVertices,
+	const StagedGeometry* staged) {
+	if (staged != nullptr) {
+		pool = &SceneGeometry::Instance().GetPool(staged->compactVertices, staged->wideIndices);
+		allocation = pool->AllocateFromBuffer(staged->buffer, 0, staged->vertexCount, staged->indexByteOffset, staged->indexCount);
+		drawId = SceneGeometry::Instance().AddDrawData(staged->drawData);
+		// The copy above is the last use, so the registry may delete the staging buffer once it is fenced
+		GpuResourceRegistry::Instance().ReleaseDeferred(GpuResourceType::Buffer, staged->buffer, staged->bytes);
+	}
+	else {
+		EncodedGeometry encoded = EncodeGeometry(vertexData, vertexCount, indexData, indexCount, compactVertices);
+		pool = &SceneGeometry::Instance().GetPool(compactVertices, encoded.wideIndices);
+		allocation = pool->Allocate(encoded.vertices, static_cast<uint32_t>(vertexCount), encoded.indices, static_cast<uint32_t>(indexCount));
+		drawId = SceneGeometry::Instance().AddDrawData(encoded.drawData);
+	}
+
+	if (!IsDrawable()) {
+		std::cout << "ERROR: Could not allocate scene pool space for a mesh with " << vertexCount << " vertices and "
+			<< indexCount << " indices; it will not be drawn\n";
+	}
 }
@@ -4,9 +4,14 @@
 
 #include "Texture.h"
 #include "Shader.h"
+#include "Meshlets.h"
+#include "VertexQuantization.h"
+#include "SceneGeometry.h"
 
 #include <vector>
+#include <string>
 #include <cstdint>
+#include <cstddef>
 
 struct Vertex {
 	glm::vec3 Position;
@@ -14,20 +19,219 @@ struct Vertex {
 	glm::vec2 TexCoords;
 };
 
+// One level of detail: a range of the mesh's index buffer and its simplification error as a fraction of the bounds radius
+struct MeshLod {
+	uint32_t indexOffset = 0;
+	uint32_t indexCount = 0;
+	float error = 0.f;
+	uint32_t padding = 0;
+};
+
+// One source mesh merged into a static batch, kept so it can still be culled on its own
+struct Submesh {
+	glm::vec3 boundsCenter = glm::vec3(0.f);
+	float boundsRadius = 0.f;
+};
+
+// A submesh's slice of one level's indices
+struct SubmeshRange {
+	uint32_t indexOffset = 0;
+	uint32_t indexCount = 0;
+};
+
+// CPU-side result of converting one imported mesh, before any GL objects exist
+struct MeshData {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<std::string> diffuseTextures;
+
+	// Level 0 covers the full-detail indices; coarser levels follow it in the same index buffer
+	std::vector<MeshLod> lods;
+	glm::vec3 boundsCenter = glm::vec3(0.f);
+	float boundsRadius = 0.f;
+
+	// Optional clustering of level 0, in index order
+	std::vector<Meshlet> meshlets;
+
+	// Only set for static batches; ranges are indexed [level * submeshes.size() + submesh] and each level lists them in order
+	std::vector<Submesh> submeshes;
+	std::vector<SubmeshRange> submeshRanges;
+};
+
+// Non-owning view of one mesh's geometry, backed by MeshData or a mapped mesh cache
+struct MeshView {
+	const Vertex* vertices = nullptr;
+	uint32_t vertexCount = 0;
+	const uint32_t* indices = nullptr;
+	uint32_t indexCount = 0;
+	const MeshLod* lods = nullptr;
+	uint32_t lodCount = 0;
+	const Meshlet* meshlets = nullptr;
+	uint32_t meshletCount = 0;
+	const Submesh* submeshes = nullptr;
+	uint32_t submeshCount = 0;
+	// submeshCount * lodCount entries
+	const SubmeshRange* submeshRanges = nullptr;
+	glm::vec3 boundsCenter = glm::vec3(0.f);
+	float boundsRadius = 0.f;
+	std::vector<std::string> diffuseTextures;
+};
+
+struct SubmeshCullStats {
+	uint32_t tested = 0;
+	uint32_t frustumCulled = 0;
+};
+
+// Fills in the bounding sphere and, when no levels were generated, a single full-detail level
+void FinalizeMeshData(MeshData& mesh);
+
+MeshView GetMeshView(const MeshData& mesh);
+
+// A mesh's encoded vertices followed by its indices in one buffer made on the upload context.
+// The buffer is a plain GL name until a Mesh adopts it, which copies it into the scene pools and frees it.
+struct StagedGeometry {
+	uint32_t buffer = 0;
+	size_t indexByteOffset = 0;
+	size_t bytes = 0;
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	bool compactVertices = false;
+	bool wideIndices = false;
+	MeshDrawData drawData;
+};
+
+// Uniforms the mesh draw paths set, resolved once per shader
+struct MeshUniforms {
+	UniformHandle<bool> compactVertices;
+	UniformHandle<bool> vertexPulling;
+
+	static MeshUniforms Resolve(const Shader& shader);
+};
+
+// Whether a mesh holds on to its vertices and indices after uploading them, e.g. for picking or export
+enum class CpuGeometryPolicy {
+	Drop,
+	Keep
+};
+
+// Owns a range of the scene pools, so it can be moved but not copied
 class Mesh {
 public:
-	Mesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices, std::vector<Texture> textures);
+	Mesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices, std::vector<Texture> textures, CpuGeometryPolicy cpuGeometry = CpuGeometryPolicy::Drop);
+
+	// Copies the geometry into the shared scene pools, straight from caller-owned memory (e.g. a mapped mesh cache).
+	// compactVertices stores CompactVertex instead of Vertex; indices are 16-bit whenever the vertex count allows.
+	// With staged set, the geometry is copied from that staging buffer instead, which is then freed.
+	Mesh(const MeshView& view, std::vector<Texture> textures, bool compactVertices = false, CpuGeometryPolicy cpuGeometry = CpuGeometryPolicy::Drop,
+		const StagedGeometry* staged = nullptr);
+
+	// Takes over data's buffers, so keeping the CPU geometry costs no extra copy and dropping it frees it right after upload
+	Mesh(MeshData&& data, std::vector<Texture> textures, bool compactVertices = false, CpuGeometryPolicy cpuGeometry = CpuGeometryPolicy::Drop,
+		const StagedGeometry* staged = nullptr);
+
+	// Encodes the geometry as the Mesh constructors would and uploads it into a new staging buffer.
+	// Makes no vertex arrays and touches no shared state, so it runs on the upload context.
+	static StagedGeometry Stage(const MeshView& view, bool compactVertices);
+
+	// Deletes a staging buffer no mesh adopted, from either context
+	static void DiscardStaged(StagedGeometry& staged);
 
-	void Draw(const Shader& shader);
+	Mesh(Mesh&& other) noexcept;
+	Mesh& operator=(Mesh&& other) noexcept;
+
+	// Returns the pool range and draw-data slot; moved-from meshes hold neither
+	~Mesh() { Release(); }
+
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
+
+	// Draws one level on its own with whatever object constants are bound; batched drawing goes through AppendDraw instead
+	void Draw(const Shader& shader, const MeshUniforms& uniforms, uint32_t lodIndex = 0);
+
+	void AppendDraw(uint32_t lodIndex, std::vector<DrawElementsIndirectCommand>& commands) const;
+
+	// Appends level 0 with hidden meshlets skipped, merging adjacent visible ones into one command; returns the triangles kept
+	size_t AppendMeshletDraws(const MeshletCullData& cullData, MeshletCullStats& stats, std::vector<DrawElementsIndirectCommand>& commands) const;
+
+	// Appends one level with submeshes outside the frustum skipped, merging adjacent visible ones; returns the triangles kept
+	size_t AppendSubmeshDraws(uint32_t lodIndex, const MeshletCullData& cullData, SubmeshCullStats& stats, std::vector<DrawElementsIndirectCommand>& commands) const;
+
+	// Returns the geometry to the scene pools; the mesh must not be drawn afterwards
+	void Release();
+
+	// Binds textures and tells the shader how this mesh's vertices are encoded
+	void BindMaterial(const Shader& shader, const MeshUniforms& uniforms);
+
+	// Same as BindMaterial, for replay later; safe on any thread
+	void RecordMaterial(CommandList& commandList, const Shader& shader, const MeshUniforms& uniforms) const;
+
+	GeometryPool& GetPool() const { return *pool; }
+
+	// False if the pools had no room for the geometry; such a mesh holds no range and must not be drawn
+	bool IsDrawable() const { return allocation != GeometryPool::INVALID_ALLOCATION; }
+
+	bool HasMeshlets() const { return !meshlets.empty(); }
+
+	size_t GetMeshletCount() const { return meshlets.size(); }
+
+	bool HasSubmeshes() const { return !submeshes.empty(); }
+
+	// Source meshes merged into this one; 1 for a mesh that was not batched
+	size_t GetSourceMeshCount() const { return submeshes.empty() ? 1 : submeshes.size(); }
+
+	uint32_t GetLodCount() const { return static_cast<uint32_t>(lods.size()); }
+
+	const MeshLod& GetLod(uint32_t lodIndex) const { return lods[lodIndex]; }
+
+	const glm::vec3& GetBoundsCenter() const { return boundsCenter; }
+
+	float GetBoundsRadius() const { return boundsRadius; }
+
+	bool HasCompactVertices() const { return pool->HasCompactVertices(); }
+
+	// Empty unless the mesh was created with CpuGeometryPolicy::Keep
+	const std::vector<Vertex>& GetVertices() const { return vertices; }
+
+	const std::vector<uint32_t>& GetIndices() const { return indices; }
+
+	bool HasCpuGeometry() const { return !vertices.empty(); }
+
+	// Retained vertex and index bytes, plus the LOD and meshlet tables every mesh keeps for drawing
+	size_t GetCpuBytes() const {
+		return vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(uint32_t)
+			+ lods.capacity() * sizeof(MeshLod) + meshlets.capacity() * sizeof(Meshlet)
+			+ submeshes.capacity() * sizeof(Submesh) + submeshRanges.capacity() * sizeof(SubmeshRange);
+	}
+
+	// Vertex and index bytes this mesh takes up in its pool
+	size_t GetGpuBytes() const {
+		if (!IsDrawable()) {
+			return 0;
+		}
+		const GeometryRange& range = pool->GetRange(allocation);
+		return static_cast<size_t>(range.vertexCount) * pool->GetVertexSize() + static_cast<size_t>(range.indexCount) * pool->GetIndexSize();
+	}
 	
 private:
 	std::vector<Vertex> vertices;
 	std::vector<uint32_t> indices;
 	std::vector<Texture> textures;
 
-	uint32_t VAO = 0;
-	uint32_t VBO = 0;
-	uint32_t EBO = 0;
+	GeometryPool* pool = nullptr;
+	uint32_t allocation = 0;
+	uint32_t drawId = 0;
+
+	std::vector<MeshLod> lods;
+	glm::vec3 boundsCenter = glm::vec3(0.f);
+	float boundsRadius = 0.f;
+
+	std::vector<Meshlet> meshlets;
+
+	std::vector<Submesh> submeshes;
+	std::vector<SubmeshRange> submeshRanges;
+
+	void Swap(Mesh& other) noexcept;
 
-	void SetupMesh();
+	void SetupMesh(const Vertex* vertexData, size_t vertexCount, const uint32_t* indexData, size_t indexCount, bool compactVertices,
+		const StagedGeometry* staged);
 };
@@ -0,0 +1,122 @@
+#include "MeshBatcher.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+	MeshData Merge(std::vector<MeshData>& meshes, const std::vector<size_t>& members) {
+		MeshData batch;
+		batch.diffuseTextures = meshes[members[0]].diffuseTextures;
+
+		size_t levelCount = 0;
+		size_t vertexCount = 0;
+		size_t indexCount = 0;
+		for (size_t member : members) {
+			levelCount = std::max(levelCount, meshes[member].lods.size());
+			vertexCount += meshes[member].vertices.size();
+			indexCount += meshes[member].indices.size();
+		}
+
+		std::vector<uint32_t> baseVertices;
+		batch.vertices.reserve(vertexCount);
+		for (size_t member : members) {
+			baseVertices.push_back(static_cast<uint32_t>(batch.vertices.size()));
+			batch.vertices.insert(batch.vertices.end(), meshes[member].vertices.begin(), meshes[member].vertices.end());
+			batch.submeshes.push_back(Submesh{ meshes[member].boundsCenter, meshes[member].boundsRadius });
+		}
+
+		// Members with fewer levels repeat their coarsest one, so every level covers every member
+		batch.indices.reserve(indexCount);
+		batch.submeshRanges.resize(levelCount * members.size());
+		for (size_t level = 0; level < levelCount; level++) {
+			MeshLod batchLod;
+			batchLod.indexOffset = static_cast<uint32_t>(batch.indices.size());
+			for (size_t i = 0; i < members.size(); i++) {
+				const MeshData& mesh = meshes[members[i]];
+				const MeshLod& lod = mesh.lods[std::min(level, mesh.lods.size() - 1)];
+
+				SubmeshRange& range = batch.submeshRanges[level * members.size() + i];
+				range.indexOffset = static_cast<uint32_t>(batch.indices.size());
+				range.indexCount = lod.indexCount;
+				for (uint32_t j = lod.indexOffset; j < lod.indexOffset + lod.indexCount; j++) {
+					batch.indices.push_back(mesh.indices[j] + baseVertices[i]);
+				}
+
+				// Absolute error for now; made relative to the batch radius once it is known
+				batchLod.error = std::max(batchLod.error, lod.error * mesh.boundsRadius);
+			}
+			batchLod.indexCount = static_cast<uint32_t>(batch.indices.size()) - batchLod.indexOffset;
+			batch.lods.push_back(batchLod);
+		}
+
+		// Meshlets index level 0, which now starts at each member's first range. They replace level 0 when drawn,
+		// so they are only kept if every member has them.
+		bool allMeshlets = std::all_of(members.begin(), members.end(), [&](size_t member) { return !meshes[member].meshlets.empty(); });
+		for (size_t i = 0; i < members.size() && allMeshlets; i++) {
+			const MeshData& mesh = meshes[members[i]];
+			for (Meshlet meshlet : mesh.meshlets) {
+				meshlet.indexOffset = meshlet.indexOffset - mesh.lods[0].indexOffset + batch.submeshRanges[i].indexOffset;
+				batch.meshlets.push_back(meshlet);
+			}
+		}
+
+		FinalizeMeshData(batch);
+		for (MeshLod& lod : batch.lods) {
+			lod.error = batch.boundsRadius > 0.f ? lod.error / batch.boundsRadius : 0.f;
+		}
+		return batch;
+	}
+}
+
+BatchReport MeshBatcher::Batch(std::vector<MeshData>& meshes, uint32_t maxVertices) {
+	BatchReport report;
+	report.meshesBefore = meshes.size();
+
+	// Greedy in import order: each mesh joins the open batch for its texture set if it still fits
+	struct OpenBatch {
+		size_t slot;
+		size_t vertexCount;
+	};
+	std::vector<std::vector<size_t>> groups;
+	std::vector<OpenBatch> openBatches;
+	for (size_t i = 0; i < meshes.size(); i++) {
+		size_t vertexCount = meshes[i].vertices.size();
+		bool placed = false;
+		for (OpenBatch& open : openBatches) {
+			const std::vector<size_t>& group = groups[open.slot];
+			if (meshes[group[0]].diffuseTextures == meshes[i].diffuseTextures) {
+				if (open.vertexCount + vertexCount <= maxVertices) {
+					groups[open.slot].push_back(i);
+					open.vertexCount += vertexCount;
+					placed = true;
+				}
+				else {
+					// Full: later meshes with this texture set start a new batch
+					open = OpenBatch{ groups.size(), vertexCount };
+					groups.push_back({ i });
+					placed = true;
+				}
+				break;
+			}
+		}
+		if (!placed) {
+			openBatches.push_back(OpenBatch{ groups.size(), vertexCount });
+			groups.push_back({ i });
+		}
+	}
+
+	std::vector<MeshData> batched;
+	batched.reserve(groups.size());
+	for (const std::vector<size_t>& group : groups) {
+		if (group.size() == 1) {
+			batched.push_back(std::move(meshes[group[0]]));
+		}
+		else {
+			batched.push_back(Merge(meshes, group));
+		}
+	}
+
+	meshes = std::move(batched);
+	report.meshesAfter = meshes.size();
+	return report;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct BatchReport {
+	size_t meshesBefore = 0;
+	size_t meshesAfter = 0;
+};
+
+// Merges static meshes that share a texture set into one vertex and index range each.
+// Runs on finalized meshes (bounds and levels filled in) whose vertices are already in model space.
+namespace MeshBatcher {
+	// 65536 keeps every batch on 16-bit indices
+	constexpr uint32_t DEFAULT_MAX_VERTICES = 1 << 16;
+
+	// Batches keep the position of their first mesh; each level concatenates the members' matching
+	// (or coarsest) level and each member stays cullable through its Submesh bounds
+	BatchReport Batch(std::vector<MeshData>& meshes, uint32_t maxVertices = DEFAULT_MAX_VERTICES);
+}
@@ -0,0 +1,296 @@
+#include "MeshCache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <mutex>
+
+namespace {
+	constexpr uint32_t CACHE_MAGIC = 0x4D4C474F; // "OGLM"
+
+	struct CacheHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t importFlags;
+		uint32_t vertexSize;
+		uint64_t sourceSize;
+		int64_t sourceWriteTime;
+		uint32_t meshCount;
+		uint32_t pipelineFlags;
+		uint32_t dependencyCount;
+		uint32_t padding;
+	};
+
+	// Followed by the path, padded to 4 bytes
+	struct CacheDependencyHeader {
+		uint64_t size;
+		int64_t writeTime;
+		uint32_t pathLength;
+		uint32_t padding;
+	};
+
+	// Recorded for a dependency that did not exist, so creating it later also invalidates the cache
+	constexpr uint64_t MISSING_FILE_SIZE = UINT64_MAX;
+
+	struct CacheMeshHeader {
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t textureCount;
+		uint32_t lodCount;
+		float boundsCenter[3];
+		float boundsRadius;
+		uint32_t meshletCount;
+		uint32_t submeshCount;
+	};
+
+	MeshCacheStats stats;
+	std::mutex statsMutex;
+
+	size_t AlignUp(size_t value, size_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	bool GetSourceInfo(const std::string& sourcePath, uint64_t& size, int64_t& writeTime) {
+		std::error_code error;
+		size = std::filesystem::file_size(sourcePath, error);
+		if (error) {
+			return false;
+		}
+		writeTime = static_cast<int64_t>(std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count());
+		return !error;
+	}
+
+	void GetDependencyInfo(const std::string& path, uint64_t& size, int64_t& writeTime) {
+		if (!GetSourceInfo(path, size, writeTime)) {
+			size = MISSING_FILE_SIZE;
+			writeTime = 0;
+		}
+	}
+
+	void WritePadding(std::ofstream& file, size_t written, size_t alignment) {
+		static const char zeros[16] = {};
+		file.write(zeros, AlignUp(written, alignment) - written);
+	}
+}
+
+std::string MeshCache::GetCachePath(const std::string& sourcePath) {
+	return sourcePath + ".meshcache";
+}
+
+bool MeshCache::Load(const std::string& sourcePath, uint32_t importFlags, uint32_t pipelineFlags, CachedModel& model) {
+	uint64_t sourceSize;
+	int64_t sourceWriteTime;
+	if (!GetSourceInfo(sourcePath, sourceSize, sourceWriteTime)) {
+		return false;
+	}
+
+	if (!model.file.Open(GetCachePath(sourcePath))) {
+		return false;
+	}
+
+	const uint8_t* data = model.file.GetData();
+	size_t size = model.file.GetSize();
+	if (size < sizeof(CacheHeader)) {
+		model.file.Close();
+		return false;
+	}
+
+	CacheHeader header;
+	std::memcpy(&header, data, sizeof(CacheHeader));
+	if (header.magic != CACHE_MAGIC || header.version != VERSION || header.importFlags != importFlags || header.pipelineFlags != pipelineFlags ||
+		header.vertexSize != sizeof(Vertex) || header.sourceSize != sourceSize || header.sourceWriteTime != sourceWriteTime) {
+		model.file.Close();
+		return false;
+	}
+
+	size_t offset = sizeof(CacheHeader);
+	for (uint32_t i = 0; i < header.dependencyCount; i++) {
+		CacheDependencyHeader dependency;
+		if (offset + sizeof(CacheDependencyHeader) > size) {
+			model.file.Close();
+			return false;
+		}
+		std::memcpy(&dependency, data + offset, sizeof(CacheDependencyHeader));
+		offset += sizeof(CacheDependencyHeader);
+		if (offset + dependency.pathLength > size) {
+			model.file.Close();
+			return false;
+		}
+
+		std::string path(reinterpret_cast<const char*>(data + offset), dependency.pathLength);
+		offset = AlignUp(offset + dependency.pathLength, 4);
+		uint64_t dependencySize;
+		int64_t dependencyWriteTime;
+		GetDependencyInfo(path, dependencySize, dependencyWriteTime);
+		if (dependencySize != dependency.size || dependencyWriteTime != dependency.writeTime) {
+			model.file.Close();
+			return false;
+		}
+	}
+
+	model.meshes.clear();
+	model.meshes.reserve(header.meshCount);
+	for (uint32_t i = 0; i < header.meshCount; i++) {
+		CacheMeshHeader meshHeader;
+		if (offset + sizeof(CacheMeshHeader) > size) {
+			break;
+		}
+		std::memcpy(&meshHeader, data + offset, sizeof(CacheMeshHeader));
+		offset += sizeof(CacheMeshHeader);
+
+		MeshView mesh;
+		bool valid = true;
+		for (uint32_t j = 0; j < meshHeader.textureCount && valid; j++) {
+			uint32_t length;
+			if (offset + sizeof(uint32_t) > size) {
+				valid = false;
+				break;
+			}
+			std::memcpy(&length, data + offset, sizeof(uint32_t));
+			offset += sizeof(uint32_t);
+			if (offset + length > size) {
+				valid = false;
+				break;
+			}
+			mesh.diffuseTextures.emplace_back(reinterpret_cast<const char*>(data + offset), length);
+			offset = AlignUp(offset + length, 4);
+		}
+
+		size_t lodBytes = static_cast<size_t>(meshHeader.lodCount) * sizeof(MeshLod);
+		size_t meshletBytes = static_cast<size_t>(meshHeader.meshletCount) * sizeof(Meshlet);
+		size_t submeshBytes = static_cast<size_t>(meshHeader.submeshCount) * sizeof(Submesh);
+		size_t submeshRangeBytes = static_cast<size_t>(meshHeader.submeshCount) * meshHeader.lodCount * sizeof(SubmeshRange);
+		size_t vertexBytes = static_cast<size_t>(meshHeader.vertexCount) * sizeof(Vertex);
+		size_t indexBytes = static_cast<size_t>(meshHeader.indexCount) * sizeof(uint32_t);
+		if (!valid || offset + lodBytes + meshletBytes + submeshBytes + submeshRangeBytes + vertexBytes + indexBytes > size) {
+			break;
+		}
+
+		mesh.boundsCenter = glm::vec3(meshHeader.boundsCenter[0], meshHeader.boundsCenter[1], meshHeader.boundsCenter[2]);
+		mesh.boundsRadius = meshHeader.boundsRadius;
+		mesh.lods = reinterpret_cast<const MeshLod*>(data + offset);
+		mesh.lodCount = meshHeader.lodCount;
+		offset += lodBytes;
+		mesh.meshlets = reinterpret_cast<const Meshlet*>(data + offset);
+		mesh.meshletCount = meshHeader.meshletCount;
+		offset += meshletBytes;
+		mesh.submeshes = reinterpret_cast<const Submesh*>(data + offset);
+		mesh.submeshCount = meshHeader.submeshCount;
+		offset += submeshBytes;
+		mesh.submeshRanges = reinterpret_cast<const SubmeshRange*>(data + offset);
+		offset += submeshRangeBytes;
+		mesh.vertices = reinterpret_cast<const Vertex*>(data + offset);
+		mesh.vertexCount = meshHeader.vertexCount;
+		offset += vertexBytes;
+		mesh.indices = reinterpret_cast<const uint32_t*>(data + offset);
+		mesh.indexCount = meshHeader.indexCount;
+		offset += indexBytes;
+
+		model.meshes.push_back(std::move(mesh));
+	}
+
+	if (model.meshes.size() != header.meshCount) {
+		std::cout << "ERROR: Mesh cache " << GetCachePath(sourcePath) << " is truncated\n";
+		model.meshes.clear();
+		model.file.Close();
+		return false;
+	}
+
+	return true;
+}
+
+bool MeshCache::Store(const std::string& sourcePath, uint32_t importFlags, uint32_t pipelineFlags, const std::vector<MeshData>& meshes,
+	const std::vector<std::string>& dependencies) {
+	CacheHeader header = {};
+	header.magic = CACHE_MAGIC;
+	header.version = VERSION;
+	header.importFlags = importFlags;
+	header.pipelineFlags = pipelineFlags;
+	header.vertexSize = sizeof(Vertex);
+	header.meshCount = static_cast<uint32_t>(meshes.size());
+	header.dependencyCount = static_cast<uint32_t>(dependencies.size());
+	if (!GetSourceInfo(sourcePath, header.sourceSize, header.sourceWriteTime)) {
+		return false;
+	}
+
+	// Write to a temporary file first so a crash never leaves a half-written cache behind
+	std::string cachePath = GetCachePath(sourcePath);
+	std::string tempPath = cachePath + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.good()) {
+			std::cout << "ERROR: Could not write mesh cache " << tempPath << "\n";
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+		for (const std::string& path : dependencies) {
+			CacheDependencyHeader dependency = {};
+			GetDependencyInfo(path, dependency.size, dependency.writeTime);
+			dependency.pathLength = static_cast<uint32_t>(path.size());
+			file.write(reinterpret_cast<const char*>(&dependency), sizeof(CacheDependencyHeader));
+			file.write(path.data(), path.size());
+			WritePadding(file, path.size(), 4);
+		}
+		for (const MeshData& mesh : meshes) {
+			CacheMeshHeader meshHeader = {};
+			meshHeader.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+			meshHeader.indexCount = static_cast<uint32_t>(mesh.indices.size());
+			meshHeader.textureCount = static_cast<uint32_t>(mesh.diffuseTextures.size());
+			meshHeader.lodCount = static_cast<uint32_t>(mesh.lods.size());
+			meshHeader.boundsCenter[0] = mesh.boundsCenter.x;
+			meshHeader.boundsCenter[1] = mesh.boundsCenter.y;
+			meshHeader.boundsCenter[2] = mesh.boundsCenter.z;
+			meshHeader.boundsRadius = mesh.boundsRadius;
+			meshHeader.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+			meshHeader.submeshCount = static_cast<uint32_t>(mesh.submeshes.size());
+			file.write(reinterpret_cast<const char*>(&meshHeader), sizeof(CacheMeshHeader));
+
+			for (const std::string& texture : mesh.diffuseTextures) {
+				uint32_t length = static_cast<uint32_t>(texture.size());
+				file.write(reinterpret_cast<const char*>(&length), sizeof(uint32_t));
+				file.write(texture.data(), length);
+				WritePadding(file, length, 4);
+			}
+
+			file.write(reinterpret_cast<const char*>(mesh.lods.data()), mesh.lods.size() * sizeof(MeshLod));
+			file.write(reinterpret_cast<const char*>(mesh.meshlets.data()), mesh.meshlets.size() * sizeof(Meshlet));
+			file.write(reinterpret_cast<const char*>(mesh.submeshes.data()), mesh.submeshes.size() * sizeof(Submesh));
+			file.write(reinterpret_cast<const char*>(mesh.submeshRanges.data()), mesh.submeshRanges.size() * sizeof(SubmeshRange));
+			file.write(reinterpret_cast<const char*>(mesh.vertices.data()), mesh.vertices.size() * sizeof(Vertex));
+			file.write(reinterpret_cast<const char*>(mesh.indices.data()), mesh.indices.size() * sizeof(uint32_t));
+		}
+
+		if (!file.good()) {
+			std::cout << "ERROR: Failed while writing mesh cache " << tempPath << "\n";
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, cachePath, error);
+	if (error) {
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+
+	return true;
+}
+
+void MeshCache::RecordLoad(bool hit, double milliseconds) {
+	std::lock_guard<std::mutex> lock(statsMutex);
+	if (hit) {
+		stats.hits++;
+	}
+	else {
+		stats.misses++;
+	}
+	stats.lastWasHit = hit;
+	stats.lastLoadMilliseconds = milliseconds;
+}
+
+MeshCacheStats MeshCache::GetStats() {
+	std::lock_guard<std::mutex> lock(statsMutex);
+	return stats;
+}
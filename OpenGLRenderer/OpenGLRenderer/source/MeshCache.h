@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Mesh.h"
+#include "MappedFile.h"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// Mapped cache file and the meshes inside it; pointers stay valid while this is alive
+struct CachedModel {
+	MappedFile file;
+	std::vector<MeshView> meshes;
+};
+
+struct MeshCacheStats {
+	uint32_t hits = 0;
+	uint32_t misses = 0;
+	bool lastWasHit = false;
+	double lastLoadMilliseconds = 0.0;
+};
+
+// Versioned on-disk cache of converted model geometry, stored next to the source file
+namespace MeshCache {
+	// Bump whenever the file layout or the conversion in Model changes
+	constexpr uint32_t VERSION = 7;
+
+	std::string GetCachePath(const std::string& sourcePath);
+
+	// Maps the cache for sourcePath; fails if it is missing, stale or was built with other import or pipeline flags.
+	// Stale covers the source and every dependency recorded when it was stored.
+	bool Load(const std::string& sourcePath, uint32_t importFlags, uint32_t pipelineFlags, CachedModel& model);
+
+	// dependencies are other files the conversion read, such as OBJ material libraries; their size and write time
+	// are stored so editing one invalidates the cache just like editing the source
+	bool Store(const std::string& sourcePath, uint32_t importFlags, uint32_t pipelineFlags, const std::vector<MeshData>& meshes,
+		const std::vector<std::string>& dependencies);
+
+	// Both may be called from any thread; loads are recorded by the background import
+	void RecordLoad(bool hit, double milliseconds);
+
+	MeshCacheStats GetStats();
+}
@@ -0,0 +1,361 @@
+#include "MeshOptimizer.h"
+
+#include <unordered_map>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <cmath>
+
+namespace {
+	constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+	constexpr float FORSYTH_CACHE_DECAY = 1.5f;
+	constexpr float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+	constexpr float FORSYTH_VALENCE_SCALE = 2.0f;
+	constexpr float FORSYTH_VALENCE_POWER = 0.5f;
+
+	struct VertexHash {
+		size_t operator()(const Vertex& vertex) const {
+			uint32_t words[sizeof(Vertex) / sizeof(uint32_t)];
+			std::memcpy(words, &vertex, sizeof(Vertex));
+			uint64_t hash = 0xCBF29CE484222325ull;
+			for (uint32_t word : words) {
+				hash = (hash ^ word) * 0x100000001B3ull;
+			}
+			return static_cast<size_t>(hash);
+		}
+	};
+
+	struct VertexEqual {
+		bool operator()(const Vertex& a, const Vertex& b) const {
+			return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+		}
+	};
+
+	float ScoreVertex(int32_t cachePosition, uint32_t activeTriangles) {
+		if (activeTriangles == 0) {
+			return -1.f;
+		}
+
+		float score = 0.f;
+		if (cachePosition >= 0) {
+			// The triangle just drawn keeps its vertices hot no matter the order
+			if (cachePosition < 3) {
+				score = FORSYTH_LAST_TRIANGLE_SCORE;
+			}
+			else {
+				float scaler = 1.f / (FORSYTH_CACHE_SIZE - 3);
+				score = std::pow(1.f - (cachePosition - 3) * scaler, FORSYTH_CACHE_DECAY);
+			}
+		}
+
+		// Favour vertices with few triangles left so they do not get stranded
+		score += FORSYTH_VALENCE_SCALE * std::pow(static_cast<float>(activeTriangles), -FORSYTH_VALENCE_POWER);
+		return score;
+	}
+}
+
+void OptimizationReport::Merge(const OptimizationReport& other) {
+	size_t total = triangles + other.triangles;
+	if (total == 0) {
+		return;
+	}
+
+	float weight = static_cast<float>(other.triangles) / total;
+	before.acmr += (other.before.acmr - before.acmr) * weight;
+	before.atvr += (other.before.atvr - before.atvr) * weight;
+	after.acmr += (other.after.acmr - after.acmr) * weight;
+	after.atvr += (other.after.atvr - after.atvr) * weight;
+	verticesBefore += other.verticesBefore;
+	verticesAfter += other.verticesAfter;
+	triangles = total;
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+	VertexCacheStats stats;
+	if (indices.size() < 3 || vertexCount == 0) {
+		return stats;
+	}
+
+	// FIFO cache as on most hardware; timestamps avoid searching the cache
+	std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+	uint32_t timestamp = cacheSize + 1;
+	size_t misses = 0;
+	for (uint32_t index : indices) {
+		if (timestamp - cacheTimestamps[index] > cacheSize) {
+			cacheTimestamps[index] = timestamp++;
+			misses++;
+		}
+	}
+
+	stats.acmr = static_cast<float>(misses) / (indices.size() / 3);
+	stats.atvr = static_cast<float>(misses) / vertexCount;
+	return stats;
+}
+
+void MeshOptimizer::WeldVertices(MeshData& mesh) {
+	std::unordered_map<Vertex, uint32_t, VertexHash, VertexEqual> uniqueVertices;
+	uniqueVertices.reserve(mesh.vertices.size());
+
+	std::vector<uint32_t> remap(mesh.vertices.size());
+	std::vector<Vertex> welded;
+	welded.reserve(mesh.vertices.size());
+	for (size_t i = 0; i < mesh.vertices.size(); i++) {
+		auto inserted = uniqueVertices.emplace(mesh.vertices[i], static_cast<uint32_t>(welded.size()));
+		if (inserted.second) {
+			welded.push_back(mesh.vertices[i]);
+		}
+		remap[i] = inserted.first->second;
+	}
+
+	for (uint32_t& index : mesh.indices) {
+		index = remap[index];
+	}
+	mesh.vertices = std::move(welded);
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) {
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// Triangle adjacency per vertex, packed into one array
+	std::vector<uint32_t> activeTriangles(vertexCount, 0);
+	for (uint32_t index : indices) {
+		activeTriangles[index]++;
+	}
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < vertexCount; i++) {
+		adjacencyOffsets[i + 1] = adjacencyOffsets[i] + activeTriangles[i];
+	}
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+		for (size_t corner = 0; corner < 3; corner++) {
+			uint32_t vertex = indices[triangle * 3 + corner];
+			adjacency[fill[vertex]++] = static_cast<uint32_t>(triangle);
+		}
+	}
+
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++) {
+		vertexScores[i] = ScoreVertex(-1, activeTriangles[i]);
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+
+	// The cache holds up to FORSYTH_CACHE_SIZE vertices plus the three being inserted
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> nextCache;
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+	size_t scanCursor = 0;
+	int64_t bestTriangle = -1;
+	for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+		if (bestTriangle < 0) {
+			// Nothing adjacent to the cache; fall back to the next unemitted triangle
+			while (emitted[scanCursor]) {
+				scanCursor++;
+			}
+			bestTriangle = static_cast<int64_t>(scanCursor);
+		}
+
+		uint32_t triangle = static_cast<uint32_t>(bestTriangle);
+		emitted[triangle] = true;
+		const uint32_t* corners = &indices[triangle * 3];
+		result.insert(result.end(), corners, corners + 3);
+
+		// Remove the triangle from its vertices' adjacency
+		for (size_t corner = 0; corner < 3; corner++) {
+			uint32_t vertex = corners[corner];
+			uint32_t* begin = &adjacency[adjacencyOffsets[vertex]];
+			uint32_t* end = begin + activeTriangles[vertex];
+			uint32_t* found = std::find(begin, end, triangle);
+			std::swap(*found, *(end - 1));
+			activeTriangles[vertex]--;
+		}
+
+		// Move the triangle's vertices to the front of the LRU cache
+		nextCache.assign(corners, corners + 3);
+		for (uint32_t vertex : cache) {
+			if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2]) {
+				nextCache.push_back(vertex);
+			}
+		}
+		if (nextCache.size() > FORSYTH_CACHE_SIZE) {
+			for (size_t i = FORSYTH_CACHE_SIZE; i < nextCache.size(); i++) {
+				vertexScores[nextCache[i]] = ScoreVertex(-1, activeTriangles[nextCache[i]]);
+			}
+			nextCache.resize(FORSYTH_CACHE_SIZE);
+		}
+		cache.swap(nextCache);
+
+		// Rescore everything in the cache and pick the best triangle touching it
+		for (size_t i = 0; i < cache.size(); i++) {
+			vertexScores[cache[i]] = ScoreVertex(static_cast<int32_t>(i), activeTriangles[cache[i]]);
+		}
+
+		bestTriangle = -1;
+		float bestScore = -1.f;
+		for (uint32_t vertex : cache) {
+			for (uint32_t j = 0; j < activeTriangles[vertex]; j++) {
+				uint32_t other = adjacency[adjacencyOffsets[vertex] + j];
+				float score = vertexScores[indices[other * 3]] + vertexScores[indices[other * 3 + 1]] + vertexScores[indices[other * 3 + 2]];
+				if (score > bestScore) {
+					bestScore = score;
+					bestTriangle = other;
+				}
+			}
+		}
+	}
+
+	indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold) {
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount < 2) {
+		return;
+	}
+
+	// Hard boundaries where the cache would start cold: every vertex of the triangle is a miss
+	std::vector<size_t> clusterStarts;
+	{
+		std::vector<uint32_t> cacheTimestamps(vertices.size(), 0);
+		uint32_t timestamp = MeshOptimizer::CACHE_SIZE + 1;
+		for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+			uint32_t misses = 0;
+			for (size_t corner = 0; corner < 3; corner++) {
+				uint32_t vertex = indices[triangle * 3 + corner];
+				if (timestamp - cacheTimestamps[vertex] > MeshOptimizer::CACHE_SIZE) {
+					cacheTimestamps[vertex] = timestamp++;
+					misses++;
+				}
+			}
+			if (misses == 3 || triangle == 0) {
+				clusterStarts.push_back(triangle);
+			}
+		}
+	}
+	clusterStarts.push_back(triangleCount);
+
+	// Soft boundaries split hard clusters further wherever the local ACMR stays within threshold.
+	// Advancing the timestamp past the cache size empties the simulated cache without clearing it.
+	std::vector<size_t> softStarts;
+	std::vector<uint32_t> cacheTimestamps(vertices.size(), 0);
+	uint32_t timestamp = MeshOptimizer::CACHE_SIZE + 1;
+	auto countMiss = [&](uint32_t vertex) {
+		if (timestamp - cacheTimestamps[vertex] > MeshOptimizer::CACHE_SIZE) {
+			cacheTimestamps[vertex] = timestamp++;
+			return 1u;
+		}
+		return 0u;
+	};
+
+	for (size_t cluster = 0; cluster + 1 < clusterStarts.size(); cluster++) {
+		size_t begin = clusterStarts[cluster];
+		size_t end = clusterStarts[cluster + 1];
+
+		timestamp += MeshOptimizer::CACHE_SIZE + 1;
+		size_t clusterMisses = 0;
+		for (size_t i = begin * 3; i < end * 3; i++) {
+			clusterMisses += countMiss(indices[i]);
+		}
+		float clusterAcmr = static_cast<float>(clusterMisses) / (end - begin);
+
+		timestamp += MeshOptimizer::CACHE_SIZE + 1;
+		size_t misses = 0;
+		size_t softBegin = begin;
+		softStarts.push_back(begin);
+		for (size_t triangle = begin; triangle < end; triangle++) {
+			for (size_t corner = 0; corner < 3; corner++) {
+				misses += countMiss(indices[triangle * 3 + corner]);
+			}
+
+			size_t softTriangles = triangle + 1 - softBegin;
+			float softAcmr = static_cast<float>(misses) / softTriangles;
+			if (triangle + 1 < end && softTriangles >= 8 && softAcmr <= clusterAcmr * threshold) {
+				softStarts.push_back(triangle + 1);
+				softBegin = triangle + 1;
+				misses = 0;
+				timestamp += MeshOptimizer::CACHE_SIZE + 1;
+			}
+		}
+	}
+	softStarts.push_back(triangleCount);
+
+	// Sort clusters by how far they face away from the mesh centre so outer surfaces draw first
+	glm::vec3 meshCentroid(0.f);
+	for (const Vertex& vertex : vertices) {
+		meshCentroid += vertex.Position;
+	}
+	meshCentroid /= static_cast<float>(vertices.size());
+
+	size_t clusterCount = softStarts.size() - 1;
+	std::vector<float> sortKeys(clusterCount);
+	for (size_t cluster = 0; cluster < clusterCount; cluster++) {
+		glm::vec3 centroid(0.f);
+		glm::vec3 normal(0.f);
+		float area = 0.f;
+		for (size_t triangle = softStarts[cluster]; triangle < softStarts[cluster + 1]; triangle++) {
+			const glm::vec3& a = vertices[indices[triangle * 3]].Position;
+			const glm::vec3& b = vertices[indices[triangle * 3 + 1]].Position;
+			const glm::vec3& c = vertices[indices[triangle * 3 + 2]].Position;
+			glm::vec3 faceNormal = glm::cross(b - a, c - a);
+			float faceArea = glm::length(faceNormal);
+			centroid += (a + b + c) * (faceArea / 3.f);
+			normal += faceNormal;
+			area += faceArea;
+		}
+		centroid = area > 0.f ? centroid / area : vertices[indices[softStarts[cluster] * 3]].Position;
+		float normalLength = glm::length(normal);
+		sortKeys[cluster] = normalLength > 0.f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.f;
+	}
+
+	std::vector<size_t> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (size_t cluster : order) {
+		result.insert(result.end(), indices.begin() + softStarts[cluster] * 3, indices.begin() + softStarts[cluster + 1] * 3);
+	}
+	indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(MeshData& mesh) {
+	constexpr uint32_t UNUSED = ~0u;
+	std::vector<uint32_t> remap(mesh.vertices.size(), UNUSED);
+	std::vector<Vertex> ordered;
+	ordered.reserve(mesh.vertices.size());
+
+	for (uint32_t& index : mesh.indices) {
+		if (remap[index] == UNUSED) {
+			remap[index] = static_cast<uint32_t>(ordered.size());
+			ordered.push_back(mesh.vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	mesh.vertices = std::move(ordered);
+}
+
+OptimizationReport MeshOptimizer::Optimize(MeshData& mesh) {
+	OptimizationReport report;
+	report.triangles = mesh.indices.size() / 3;
+	report.verticesBefore = mesh.vertices.size();
+	report.before = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+	WeldVertices(mesh);
+	OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+	OptimizeOverdraw(mesh.indices, mesh.vertices);
+	OptimizeVertexFetch(mesh);
+
+	report.verticesAfter = mesh.vertices.size();
+	report.after = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+	return report;
+}
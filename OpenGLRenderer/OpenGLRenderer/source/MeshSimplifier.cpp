@@ -0,0 +1,358 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+namespace {
+	// Normal and UV differences cost as much as moving this fraction of the radius
+	constexpr float ATTRIBUTE_WEIGHT = 0.05f;
+	// Reject collapses that turn a triangle by more than about 80 degrees
+	constexpr float MIN_NORMAL_DOT = 0.2f;
+
+	// Symmetric 4x4 plane quadric stored as its upper triangle, plus the total weight of its planes
+	struct Quadric {
+		double a2 = 0, ab = 0, ac = 0, ad = 0;
+		double b2 = 0, bc = 0, bd = 0;
+		double c2 = 0, cd = 0;
+		double d2 = 0;
+		double weight = 0;
+
+		void AddPlane(const glm::vec3& normal, float distance, float planeWeight) {
+			double a = normal.x, b = normal.y, c = normal.z, d = distance;
+			a2 += a * a * planeWeight; ab += a * b * planeWeight; ac += a * c * planeWeight; ad += a * d * planeWeight;
+			b2 += b * b * planeWeight; bc += b * c * planeWeight; bd += b * d * planeWeight;
+			c2 += c * c * planeWeight; cd += c * d * planeWeight;
+			d2 += d * d * planeWeight;
+			weight += planeWeight;
+		}
+
+		void Add(const Quadric& other) {
+			a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+			b2 += other.b2; bc += other.bc; bd += other.bd;
+			c2 += other.c2; cd += other.cd;
+			d2 += other.d2;
+			weight += other.weight;
+		}
+
+		// Weighted mean squared distance to the planes, so it scales with the mesh and not with its area
+		double Evaluate(const glm::vec3& point) const {
+			double x = point.x, y = point.y, z = point.z;
+			double result = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+				+ b2 * y * y + 2 * bc * y * z + 2 * bd * y
+				+ c2 * z * z + 2 * cd * z
+				+ d2;
+			return result > 0 && weight > 0 ? result / weight : 0;
+		}
+	};
+
+	struct Collapse {
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+
+	struct PositionHash {
+		size_t operator()(const glm::vec3& position) const {
+			uint32_t words[3];
+			std::memcpy(words, &position, sizeof(words));
+			uint64_t hash = 0xCBF29CE484222325ull;
+			for (uint32_t word : words) {
+				hash = (hash ^ word) * 0x100000001B3ull;
+			}
+			return static_cast<size_t>(hash);
+		}
+	};
+
+	struct PositionEqual {
+		bool operator()(const glm::vec3& a, const glm::vec3& b) const {
+			return std::memcmp(&a, &b, sizeof(glm::vec3)) == 0;
+		}
+	};
+
+	float AttributeDistance(const Vertex& a, const Vertex& b) {
+		glm::vec3 normal = a.Normal - b.Normal;
+		glm::vec2 texCoords = a.TexCoords - b.TexCoords;
+		return glm::dot(normal, normal) + glm::dot(texCoords, texCoords);
+	}
+
+	float ComputeRadius(const std::vector<Vertex>& vertices) {
+		if (vertices.empty()) {
+			return 0.f;
+		}
+
+		glm::vec3 minimum = vertices[0].Position;
+		glm::vec3 maximum = vertices[0].Position;
+		for (const Vertex& vertex : vertices) {
+			minimum = glm::min(minimum, vertex.Position);
+			maximum = glm::max(maximum, vertex.Position);
+		}
+		return 0.5f * glm::length(maximum - minimum);
+	}
+
+	uint32_t Resolve(std::vector<uint32_t>& remap, uint32_t vertex) {
+		while (remap[vertex] != vertex) {
+			remap[vertex] = remap[remap[vertex]];
+			vertex = remap[vertex];
+		}
+		return vertex;
+	}
+}
+
+std::vector<uint32_t> MeshSimplifier::Simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount,
+	float maxError, float& resultError) {
+	resultError = 0.f;
+	std::vector<uint32_t> result = indices;
+	if (vertices.empty() || indices.size() <= targetIndexCount) {
+		return result;
+	}
+
+	// Vertices at the same position are wedges of one node; collapses move whole nodes
+	size_t vertexCount = vertices.size();
+	std::vector<uint32_t> nodeOf(vertexCount);
+	{
+		std::unordered_map<glm::vec3, uint32_t, PositionHash, PositionEqual> firstAtPosition;
+		firstAtPosition.reserve(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++) {
+			nodeOf[i] = firstAtPosition.emplace(vertices[i].Position, static_cast<uint32_t>(i)).first->second;
+		}
+	}
+
+	std::vector<uint32_t> wedgeOffsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < vertexCount; i++) {
+		wedgeOffsets[nodeOf[i] + 1]++;
+	}
+	for (size_t i = 0; i < vertexCount; i++) {
+		wedgeOffsets[i + 1] += wedgeOffsets[i];
+	}
+	std::vector<uint32_t> wedges(vertexCount);
+	{
+		std::vector<uint32_t> fill(wedgeOffsets.begin(), wedgeOffsets.end() - 1);
+		for (size_t i = 0; i < vertexCount; i++) {
+			wedges[fill[nodeOf[i]]++] = static_cast<uint32_t>(i);
+		}
+	}
+
+	// Border nodes are locked so open edges and silhouettes keep their shape
+	std::vector<bool> locked(vertexCount, false);
+	{
+		std::unordered_map<uint64_t, uint32_t> directedEdges;
+		directedEdges.reserve(indices.size());
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			for (size_t corner = 0; corner < 3; corner++) {
+				uint64_t a = nodeOf[indices[i + corner]];
+				uint64_t b = nodeOf[indices[i + (corner + 1) % 3]];
+				directedEdges[(a << 32) | b]++;
+			}
+		}
+		for (const auto& edge : directedEdges) {
+			uint64_t a = edge.first >> 32;
+			uint64_t b = edge.first & 0xFFFFFFFFull;
+			if (directedEdges.find((b << 32) | a) == directedEdges.end()) {
+				locked[a] = true;
+				locked[b] = true;
+			}
+		}
+	}
+
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		const glm::vec3& a = vertices[indices[i]].Position;
+		const glm::vec3& b = vertices[indices[i + 1]].Position;
+		const glm::vec3& c = vertices[indices[i + 2]].Position;
+		glm::vec3 normal = glm::cross(b - a, c - a);
+		float area = glm::length(normal);
+		if (area <= 0.f) {
+			continue;
+		}
+		normal /= area;
+		Quadric quadric;
+		quadric.AddPlane(normal, -glm::dot(normal, a), area);
+		for (size_t corner = 0; corner < 3; corner++) {
+			quadrics[nodeOf[indices[i + corner]]].Add(quadric);
+		}
+	}
+
+	float radius = ComputeRadius(vertices);
+	double attributeScale = static_cast<double>(ATTRIBUTE_WEIGHT * radius) * (ATTRIBUTE_WEIGHT * radius);
+	double maxCost = static_cast<double>(maxError) * maxError;
+
+	// Each wedge maps to the target wedge with the closest attributes
+	auto wedgeTarget = [&](uint32_t wedge, uint32_t node, float& distance) {
+		uint32_t best = wedges[wedgeOffsets[node]];
+		distance = AttributeDistance(vertices[wedge], vertices[best]);
+		for (uint32_t i = wedgeOffsets[node] + 1; i < wedgeOffsets[node + 1]; i++) {
+			float candidate = AttributeDistance(vertices[wedge], vertices[wedges[i]]);
+			if (candidate < distance) {
+				distance = candidate;
+				best = wedges[i];
+			}
+		}
+		return best;
+	};
+
+	std::vector<uint32_t> vertexRemap(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++) {
+		vertexRemap[i] = static_cast<uint32_t>(i);
+	}
+
+	std::vector<uint32_t> triangleOffsets;
+	std::vector<uint32_t> triangles;
+	std::vector<Collapse> collapses;
+	std::vector<bool> touched(vertexCount);
+	size_t indexCount = result.size();
+
+	while (indexCount > targetIndexCount) {
+		// Node to triangle adjacency for the current triangles
+		triangleOffsets.assign(vertexCount + 1, 0);
+		for (uint32_t index : result) {
+			triangleOffsets[nodeOf[index] + 1]++;
+		}
+		for (size_t i = 0; i < vertexCount; i++) {
+			triangleOffsets[i + 1] += triangleOffsets[i];
+		}
+		triangles.resize(result.size());
+		{
+			std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+			for (size_t i = 0; i < result.size(); i++) {
+				triangles[fill[nodeOf[result[i]]]++] = static_cast<uint32_t>(i / 3);
+			}
+		}
+
+		collapses.clear();
+		for (size_t i = 0; i < result.size(); i += 3) {
+			for (size_t corner = 0; corner < 3; corner++) {
+				uint32_t from = nodeOf[result[i + corner]];
+				uint32_t to = nodeOf[result[i + (corner + 1) % 3]];
+				for (int direction = 0; direction < 2; direction++) {
+					if (!locked[from] && from != to) {
+						double cost = quadrics[from].Evaluate(vertices[to].Position);
+						for (uint32_t w = wedgeOffsets[from]; w < wedgeOffsets[from + 1]; w++) {
+							float distance;
+							wedgeTarget(wedges[w], to, distance);
+							cost += attributeScale * distance;
+						}
+						collapses.push_back(Collapse{ from, to, cost });
+					}
+					std::swap(from, to);
+				}
+			}
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+			return a.cost < b.cost || (a.cost == b.cost && (a.from < b.from || (a.from == b.from && a.to < b.to)));
+		});
+
+		std::fill(touched.begin(), touched.end(), false);
+		size_t collapsedCount = 0;
+		for (const Collapse& collapse : collapses) {
+			if (indexCount <= targetIndexCount || collapse.cost > maxCost) {
+				break;
+			}
+			if (touched[collapse.from] || touched[collapse.to]) {
+				continue;
+			}
+
+			// Reject the collapse if a surviving triangle around the moved node would flip or degenerate
+			const glm::vec3& target = vertices[collapse.to].Position;
+			bool flips = false;
+			size_t removedTriangles = 0;
+			for (uint32_t t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1] && !flips; t++) {
+				const uint32_t* corners = &result[triangles[t] * 3];
+				uint32_t nodes[3] = { nodeOf[corners[0]], nodeOf[corners[1]], nodeOf[corners[2]] };
+				if (nodes[0] == collapse.to || nodes[1] == collapse.to || nodes[2] == collapse.to) {
+					removedTriangles++;
+					continue;
+				}
+
+				glm::vec3 before[3];
+				glm::vec3 after[3];
+				for (size_t corner = 0; corner < 3; corner++) {
+					before[corner] = vertices[nodes[corner]].Position;
+					after[corner] = nodes[corner] == collapse.from ? target : before[corner];
+				}
+				glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+				glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+				float lengths = glm::length(normalBefore) * glm::length(normalAfter);
+				flips = lengths <= 0.f || glm::dot(normalBefore, normalAfter) < MIN_NORMAL_DOT * lengths;
+			}
+			if (flips) {
+				continue;
+			}
+
+			for (uint32_t w = wedgeOffsets[collapse.from]; w < wedgeOffsets[collapse.from + 1]; w++) {
+				float distance;
+				vertexRemap[wedges[w]] = wedgeTarget(wedges[w], collapse.to, distance);
+			}
+			quadrics[collapse.to].Add(quadrics[collapse.from]);
+
+			// Neighbours are frozen for the rest of the pass since their triangles just changed
+			for (uint32_t t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1]; t++) {
+				const uint32_t* corners = &result[triangles[t] * 3];
+				for (size_t corner = 0; corner < 3; corner++) {
+					touched[nodeOf[corners[corner]]] = true;
+				}
+			}
+
+			indexCount -= removedTriangles * 3;
+			resultError = std::max(resultError, static_cast<float>(std::sqrt(collapse.cost)));
+			collapsedCount++;
+		}
+
+		if (collapsedCount == 0) {
+			break;
+		}
+
+		// Apply the pass and drop triangles that collapsed to a line
+		size_t write = 0;
+		for (size_t i = 0; i < result.size(); i += 3) {
+			uint32_t a = Resolve(vertexRemap, result[i]);
+			uint32_t b = Resolve(vertexRemap, result[i + 1]);
+			uint32_t c = Resolve(vertexRemap, result[i + 2]);
+			if (nodeOf[a] == nodeOf[b] || nodeOf[b] == nodeOf[c] || nodeOf[a] == nodeOf[c]) {
+				continue;
+			}
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+		result.resize(write);
+		indexCount = write;
+	}
+
+	return result;
+}
+
+void MeshSimplifier::GenerateLods(MeshData& mesh, const LodSettings& settings, bool optimizeVertexCache) {
+	float radius = ComputeRadius(mesh.vertices);
+	std::vector<uint32_t> baseIndices = mesh.indices;
+
+	mesh.lods.clear();
+	mesh.lods.push_back(MeshLod{ 0, static_cast<uint32_t>(baseIndices.size()), 0.f });
+
+	std::vector<uint32_t> previous = baseIndices;
+	while (mesh.lods.size() < settings.maxLodCount) {
+		size_t target = static_cast<size_t>(previous.size() / 3 * settings.reductionRatio) * 3;
+		float error;
+		std::vector<uint32_t> simplified = Simplify(mesh.vertices, baseIndices, target, settings.maxRelativeError * radius, error);
+
+		// Stop once simplification stalls; a level barely smaller than the last is not worth storing
+		if (simplified.empty() || simplified.size() > previous.size() * 9 / 10) {
+			break;
+		}
+
+		if (optimizeVertexCache) {
+			MeshOptimizer::OptimizeVertexCache(simplified, mesh.vertices.size());
+		}
+
+		MeshLod lod;
+		lod.indexOffset = static_cast<uint32_t>(mesh.indices.size());
+		lod.indexCount = static_cast<uint32_t>(simplified.size());
+		lod.error = radius > 0.f ? error / radius : 0.f;
+		mesh.lods.push_back(lod);
+		mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+		previous = std::move(simplified);
+	}
+}
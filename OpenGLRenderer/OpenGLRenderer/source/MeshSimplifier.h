@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct LodSettings {
+	// Each level aims for this fraction of the previous level's triangles
+	float reductionRatio = 0.5f;
+	// Largest allowed simplification error as a fraction of the mesh bounds radius
+	float maxRelativeError = 0.1f;
+	uint32_t maxLodCount = 4;
+};
+
+// Quadric-error edge collapse over the mesh's existing vertices, so every level shares one vertex buffer
+namespace MeshSimplifier {
+	// Collapses edges until indices shrink to targetIndexCount or the next collapse would exceed maxError
+	// (object-space distance, the area-weighted RMS distance to the original planes). Normals and UVs are
+	// penalised in the same squared units, scaled by the mesh radius, so seams and creases collapse last.
+	std::vector<uint32_t> Simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount,
+		float maxError, float& resultError);
+
+	// Appends coarser levels after the base level in mesh.indices and records them in mesh.lods
+	void GenerateLods(MeshData& mesh, const LodSettings& settings, bool optimizeVertexCache);
+}
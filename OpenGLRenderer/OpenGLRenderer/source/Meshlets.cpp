@@ -0,0 +1,221 @@
+#include "Meshlets.h"
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	// Normal cones wider than this (about 84 degrees) would almost never cull, so they are not stored
+	constexpr float MIN_CONE_DOT = 0.1f;
+
+	void ComputeBounds(Meshlet& meshlet, const std::vector<Vertex>& vertices, const uint32_t* indices) {
+		uint32_t indexCount = meshlet.triangleCount * 3;
+		glm::vec3 minimum = vertices[indices[0]].Position;
+		glm::vec3 maximum = minimum;
+		for (uint32_t i = 1; i < indexCount; i++) {
+			minimum = glm::min(minimum, vertices[indices[i]].Position);
+			maximum = glm::max(maximum, vertices[indices[i]].Position);
+		}
+
+		meshlet.center = 0.5f * (minimum + maximum);
+		meshlet.radius = 0.f;
+		for (uint32_t i = 0; i < indexCount; i++) {
+			meshlet.radius = std::max(meshlet.radius, glm::length(vertices[indices[i]].Position - meshlet.center));
+		}
+
+		std::vector<glm::vec3> normals;
+		normals.reserve(meshlet.triangleCount);
+		glm::vec3 normalSum(0.f);
+		for (uint32_t i = 0; i < indexCount; i += 3) {
+			const glm::vec3& a = vertices[indices[i]].Position;
+			glm::vec3 normal = glm::cross(vertices[indices[i + 1]].Position - a, vertices[indices[i + 2]].Position - a);
+			float length = glm::length(normal);
+			if (length > 0.f) {
+				normals.push_back(normal / length);
+				normalSum += normals.back();
+			}
+		}
+
+		meshlet.coneCutoff = 2.f;
+		float sumLength = glm::length(normalSum);
+		if (normals.empty() || sumLength <= 0.f) {
+			return;
+		}
+
+		meshlet.coneAxis = normalSum / sumLength;
+		float minimumDot = 1.f;
+		for (const glm::vec3& normal : normals) {
+			minimumDot = std::min(minimumDot, glm::dot(normal, meshlet.coneAxis));
+		}
+
+		if (minimumDot > MIN_CONE_DOT) {
+			meshlet.coneCutoff = std::sqrt(1.f - minimumDot * minimumDot);
+		}
+	}
+}
+
+void Meshlets::Build(MeshData& mesh) {
+	mesh.meshlets.clear();
+
+	uint32_t baseIndexCount = mesh.lods.empty() ? static_cast<uint32_t>(mesh.indices.size()) : mesh.lods[0].indexCount;
+	uint32_t triangleCount = baseIndexCount / 3;
+	size_t vertexCount = mesh.vertices.size();
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// Triangles around each vertex
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (uint32_t i = 0; i < triangleCount * 3; i++) {
+		adjacencyOffsets[mesh.indices[i] + 1]++;
+	}
+	for (size_t i = 0; i < vertexCount; i++) {
+		adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+	}
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (uint32_t i = 0; i < triangleCount * 3; i++) {
+		adjacency[fill[mesh.indices[i]]++] = i / 3;
+	}
+
+	std::vector<bool> used(triangleCount, false);
+	// Which meshlet (plus one) each vertex was last added to
+	std::vector<uint32_t> vertexMeshlet(vertexCount, 0);
+	std::vector<uint32_t> order;
+	order.reserve(triangleCount);
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> triangles;
+	uint32_t nextSeed = 0;
+
+	auto countNewVertices = [&](uint32_t triangle, uint32_t stamp) {
+		uint32_t count = 0;
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			count += vertexMeshlet[mesh.indices[triangle * 3 + corner]] != stamp;
+		}
+		return count;
+	};
+
+	while (order.size() < triangleCount) {
+		uint32_t stamp = static_cast<uint32_t>(mesh.meshlets.size()) + 1;
+		uint32_t meshletVertices = 0;
+		triangles.clear();
+		candidates.clear();
+
+		while (triangles.size() < Meshlets::MAX_TRIANGLES) {
+			// Grow through shared vertices, preferring triangles that add the fewest new ones and
+			// then the earliest, so the vertex cache order from the optimizer is mostly kept
+			uint32_t best = UINT32_MAX;
+			uint32_t bestNew = 4;
+			if (triangles.empty()) {
+				while (used[nextSeed]) {
+					nextSeed++;
+				}
+				best = nextSeed;
+				bestNew = 3;
+			}
+			else {
+				for (uint32_t candidate : candidates) {
+					if (used[candidate]) {
+						continue;
+					}
+					uint32_t newVertices = countNewVertices(candidate, stamp);
+					if (meshletVertices + newVertices > Meshlets::MAX_VERTICES) {
+						continue;
+					}
+					if (newVertices < bestNew || (newVertices == bestNew && candidate < best)) {
+						best = candidate;
+						bestNew = newVertices;
+					}
+				}
+			}
+
+			if (best == UINT32_MAX) {
+				break;
+			}
+
+			used[best] = true;
+			triangles.push_back(best);
+			meshletVertices += bestNew;
+			for (uint32_t corner = 0; corner < 3; corner++) {
+				uint32_t vertex = mesh.indices[best * 3 + corner];
+				if (vertexMeshlet[vertex] == stamp) {
+					continue;
+				}
+				vertexMeshlet[vertex] = stamp;
+				for (uint32_t i = adjacencyOffsets[vertex]; i < adjacencyOffsets[vertex + 1]; i++) {
+					if (!used[adjacency[i]]) {
+						candidates.push_back(adjacency[i]);
+					}
+				}
+			}
+		}
+
+		std::sort(triangles.begin(), triangles.end());
+
+		Meshlet meshlet;
+		meshlet.indexOffset = static_cast<uint32_t>(order.size() * 3);
+		meshlet.triangleCount = static_cast<uint32_t>(triangles.size());
+		meshlet.vertexCount = meshletVertices;
+		mesh.meshlets.push_back(meshlet);
+		order.insert(order.end(), triangles.begin(), triangles.end());
+	}
+
+	std::vector<uint32_t> reordered(triangleCount * 3);
+	for (uint32_t i = 0; i < triangleCount; i++) {
+		std::copy_n(mesh.indices.begin() + order[i] * 3, 3, reordered.begin() + i * 3);
+	}
+	std::copy(reordered.begin(), reordered.end(), mesh.indices.begin());
+
+	for (Meshlet& meshlet : mesh.meshlets) {
+		ComputeBounds(meshlet, mesh.vertices, mesh.indices.data() + meshlet.indexOffset);
+	}
+}
+
+MeshletCullData Meshlets::GetCullData(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection) {
+	MeshletCullData cullData;
+
+	// Gribb-Hartmann planes of the full transform land in the mesh's own space
+	glm::mat4 transform = projection * view * model;
+	glm::vec4 rowX(transform[0][0], transform[1][0], transform[2][0], transform[3][0]);
+	glm::vec4 rowY(transform[0][1], transform[1][1], transform[2][1], transform[3][1]);
+	glm::vec4 rowZ(transform[0][2], transform[1][2], transform[2][2], transform[3][2]);
+	glm::vec4 rowW(transform[0][3], transform[1][3], transform[2][3], transform[3][3]);
+	cullData.planes[0] = rowW + rowX;
+	cullData.planes[1] = rowW - rowX;
+	cullData.planes[2] = rowW + rowY;
+	cullData.planes[3] = rowW - rowY;
+	cullData.planes[4] = rowW + rowZ;
+	cullData.planes[5] = rowW - rowZ;
+	for (glm::vec4& plane : cullData.planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+
+	cullData.cameraPosition = glm::vec3(glm::inverse(view * model) * glm::vec4(0.f, 0.f, 0.f, 1.f));
+	return cullData;
+}
+
+bool Meshlets::IsSphereInFrustum(const glm::vec3& center, float radius, const MeshletCullData& cullData) {
+	for (const glm::vec4& plane : cullData.planes) {
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Meshlets::IsVisible(const Meshlet& meshlet, const MeshletCullData& cullData, MeshletCullStats& stats) {
+	stats.tested++;
+
+	if (!IsSphereInFrustum(meshlet.center, meshlet.radius, cullData)) {
+		stats.frustumCulled++;
+		return false;
+	}
+
+	glm::vec3 toCenter = meshlet.center - cullData.cameraPosition;
+	if (glm::dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius) {
+		stats.backfaceCulled++;
+		return false;
+	}
+
+	return true;
+}
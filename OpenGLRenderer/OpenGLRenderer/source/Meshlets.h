@@ -0,0 +1,49 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+#include <vector>
+#include <cstdint>
+
+struct MeshData;
+
+// A contiguous run of a mesh's full-detail triangles, small enough to cull on its own.
+// The normal cone is stored so that the cluster is entirely back-facing whenever
+// dot(center - camera, coneAxis) >= coneCutoff * |center - camera| + radius.
+struct Meshlet {
+	uint32_t indexOffset = 0;
+	uint32_t triangleCount = 0;
+	uint32_t vertexCount = 0;
+	glm::vec3 center = glm::vec3(0.f);
+	float radius = 0.f;
+	glm::vec3 coneAxis = glm::vec3(0.f, 0.f, 1.f);
+	// Sine of the cone's half-angle; above 1 when the normals spread too far to ever cull
+	float coneCutoff = 2.f;
+};
+
+// Frustum planes and camera position in the mesh's own space, built once per model per frame
+struct MeshletCullData {
+	glm::vec4 planes[6];
+	glm::vec3 cameraPosition = glm::vec3(0.f);
+};
+
+struct MeshletCullStats {
+	uint32_t tested = 0;
+	uint32_t frustumCulled = 0;
+	uint32_t backfaceCulled = 0;
+};
+
+namespace Meshlets {
+	constexpr uint32_t MAX_VERTICES = 64;
+	constexpr uint32_t MAX_TRIANGLES = 124;
+
+	// Regroups the full-detail triangles into meshlets and fills mesh.meshlets; run before LODs are appended
+	void Build(MeshData& mesh);
+
+	MeshletCullData GetCullData(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection);
+
+	bool IsSphereInFrustum(const glm::vec3& center, float radius, const MeshletCullData& cullData);
+
+	// Returns false if the meshlet is outside the frustum or faces away from the camera, counting why in stats
+	bool IsVisible(const Meshlet& meshlet, const MeshletCullData& cullData, MeshletCullStats& stats);
+}
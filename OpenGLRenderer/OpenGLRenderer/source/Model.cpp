@@ -1,57 +1,668 @@
 #include "Model.h"
+#include "glad/glad.h"
+#include "ThreadPool.h"
+#include "ObjLoader.h"
+#include "RingBuffer.h"
+#include "GLState.h"
 #include "assimp/Importer.hpp"
 #include "assimp/postprocess.h"
 
 #include <iostream>
+#include <cstring>
 #include <cstdint>
+#include <chrono>
+#include <cctype>
+#include <algorithm>
+#include <functional>
 
-Model::Model(const std::string& path, bool flipTextures) {
-	Assimp::Importer importer;
+constexpr uint32_t IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals;
 
-	const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals);
-	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-		std::cout << "ASSIMP ERROR: " << importer.GetErrorString() << "\n";
+// Matches the ObjectConstants block in BasicTexture.vert
+struct ObjectConstants {
+	glm::mat4 model;
+	glm::mat4 normalMatrix;
+};
+
+constexpr uint32_t OBJECT_CONSTANTS_BINDING = 1;
+
+enum PipelineFlags : uint32_t {
+	PIPELINE_OPTIMIZE = 1 << 0,
+	PIPELINE_LODS = 1 << 1,
+	PIPELINE_MESHLETS = 1 << 2,
+	PIPELINE_BATCH = 1 << 3
+};
+
+namespace {
+	// Below this many meshes per slice, waking the workers costs more than it saves
+	constexpr size_t MIN_MESHES_PER_SLICE = 256;
+
+	// Runs body for every slice, on the worker pool only when there is more than one
+	template <typename Body>
+	void RunSlices(size_t sliceCount, const Body& body) {
+		if (sliceCount == 1) {
+			body(0);
+			return;
+		}
+		ThreadPool::Shared().ParallelFor(sliceCount, body);
+	}
+
+	bool IsCancelled(const LoadStatus* status) {
+		return status != nullptr && status->cancelRequested.load();
+	}
+
+	bool IsObjFile(const std::string& path) {
+		if (path.size() < 4) {
+			return false;
+		}
+		std::string extension = path.substr(path.size() - 4);
+		for (char& c : extension) {
+			c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+		}
+		return extension == ".obj";
+	}
+}
+
+uint32_t ImportOptions::GetPipelineFlags() const {
+	uint32_t flags = 0;
+	if (optimizeMeshes) {
+		flags |= PIPELINE_OPTIMIZE;
+	}
+	if (generateLods) {
+		flags |= PIPELINE_LODS;
+	}
+	if (buildMeshlets) {
+		flags |= PIPELINE_MESHLETS;
+	}
+	if (batchMeshes) {
+		flags |= PIPELINE_BATCH;
+	}
+	return flags;
+}
+
+Model::Model(const std::string& path, const ImportOptions& options) {
+	ModelData data;
+	if (!Import(path, options, data)) {
 		return;
 	}
 
-	directory = path.substr(0, path.find_last_of('\\'));
-	this->flipTextures = flipTextures;
+	while (!UploadNext(data)) {
+	}
+}
 
-	ProcessNode(scene->mRootNode, scene);
+Model::~Model() {
+	for (const Texture& texture : loadedTextures) {
+		TextureCache::Instance().Release(texture);
+	}
 }
 
 void Model::Draw(const Shader& shader) {
-	for (Mesh& mesh : meshes) {
-		mesh.Draw(shader);
+	DrawContext context;
+	context.enableLods = false;
+	context.cullMeshlets = false;
+	context.cullSubmeshes = false;
+	Draw(shader, context);
+}
+
+void Model::Draw(const Shader& shader, const DrawContext& context) {
+	auto start = std::chrono::steady_clock::now();
+	activeLods.resize(meshes.size());
+	lastDrawStats = DrawStats();
+
+	MeshletCullData cullData;
+	if (context.cullMeshlets || context.cullSubmeshes) {
+		cullData = Meshlets::GetCullData(context.model, context.view, context.projection);
+	}
+
+	if (uniformsProgram != shader.GetId()) {
+		uniforms = MeshUniforms::Resolve(shader);
+		uniformsProgram = shader.GetId();
+		const ShaderBlockInfo* objectBlock = shader.FindUniformBlock("ObjectConstants");
+		if (objectBlock != nullptr && (objectBlock->binding != OBJECT_CONSTANTS_BINDING || objectBlock->dataSize != sizeof(ObjectConstants))) {
+			std::cout << "ERROR: Shader's ObjectConstants block does not match the layout Model writes\n";
+		}
+	}
+
+	drawItems.clear();
+	for (uint32_t bucketIndex = 0; bucketIndex < buckets.size(); bucketIndex++) {
+		for (uint32_t meshIndex : buckets[bucketIndex].meshIndices) {
+			drawItems.push_back(DrawItem{ bucketIndex, meshIndex });
+		}
+	}
+
+	size_t sliceCount = 1;
+	if (context.parallelRecording) {
+		size_t threads = static_cast<size_t>(ThreadPool::Shared().GetThreadCount()) + 1;
+		sliceCount = std::max<size_t>(1, std::min(threads, drawItems.size() / MIN_MESHES_PER_SLICE));
+	}
+	if (slices.size() < sliceCount) {
+		slices.resize(sliceCount);
+	}
+	lastDrawStats.recordingSlices = static_cast<uint32_t>(sliceCount);
+
+	// Keys hold only the low bits of the program name; that is enough to keep programs apart in practice
+	uint32_t programKey = shader.GetId();
+	// Every command's index has to fit in a key's payload, so the slices share that range
+	size_t maxSliceCommands = (static_cast<size_t>(RenderQueue::MAX_PAYLOAD) + 1) / sliceCount;
+	RunSlices(sliceCount, [&](size_t sliceIndex) {
+		PrepareSlice(slices[sliceIndex], drawItems.size() * sliceIndex / sliceCount, drawItems.size() * (sliceIndex + 1) / sliceCount,
+			context, cullData, programKey, maxSliceCommands);
+	});
+
+	drawCommands.clear();
+	renderQueue.Clear();
+	for (size_t sliceIndex = 0; sliceIndex < sliceCount; sliceIndex++) {
+		const DrawSlice& slice = slices[sliceIndex];
+		uint32_t commandBase = static_cast<uint32_t>(drawCommands.size());
+		drawCommands.insert(drawCommands.end(), slice.commands.begin(), slice.commands.end());
+		for (size_t i = 0; i < slice.keys.size(); i++) {
+			renderQueue.Push(slice.keys[i], commandBase + static_cast<uint32_t>(i));
+		}
+
+		lastDrawStats.triangles += slice.stats.triangles;
+		lastDrawStats.meshlets.tested += slice.stats.meshlets.tested;
+		lastDrawStats.meshlets.frustumCulled += slice.stats.meshlets.frustumCulled;
+		lastDrawStats.meshlets.backfaceCulled += slice.stats.meshlets.backfaceCulled;
+		lastDrawStats.submeshes.tested += slice.stats.submeshes.tested;
+		lastDrawStats.submeshes.frustumCulled += slice.stats.submeshes.frustumCulled;
+	}
+	lastDrawStats.commands = static_cast<uint32_t>(drawCommands.size());
+
+	renderQueue.Sort();
+	lastDrawStats.queue = renderQueue.GetStats();
+
+	auto prepared = std::chrono::steady_clock::now();
+	lastDrawStats.prepareMilliseconds = std::chrono::duration<double, std::milli>(prepared - start).count();
+
+	if (!drawCommands.empty()) {
+		SceneGeometry& geometry = SceneGeometry::Instance();
+		if (context.vertexPulling) {
+			geometry.PrepareVertexPulling();
+		}
+
+		// Commands are laid out in key order, so each bucket's share of a slice is contiguous for multi-draw
+		sortedCommands.resize(renderQueue.GetEntries().size());
+		RunSlices(sliceCount, [&](size_t sliceIndex) {
+			RecordSlice(slices[sliceIndex], sortedCommands.size() * sliceIndex / sliceCount, sortedCommands.size() * (sliceIndex + 1) / sliceCount,
+				shader, context);
+		});
+
+		auto recorded = std::chrono::steady_clock::now();
+		lastDrawStats.recordMilliseconds = std::chrono::duration<double, std::milli>(recorded - prepared).count();
+
+		ObjectConstants objectConstants;
+		objectConstants.model = context.model;
+		objectConstants.normalMatrix = glm::transpose(glm::inverse(context.model));
+
+		RingBuffer& ring = RingBuffer::Instance();
+		RingAllocation constants = ring.Allocate(sizeof(ObjectConstants), ring.GetUniformAlignment());
+		if (constants.data != nullptr) {
+			std::memcpy(constants.data, &objectConstants, sizeof(ObjectConstants));
+			GLStateCache::Instance().BindBufferRange(GL_UNIFORM_BUFFER, OBJECT_CONSTANTS_BINDING, constants.buffer, constants.offset, sizeof(ObjectConstants));
+		}
+		else {
+			// The ring counts the overflow; the model still draws from its own buffer
+			if (objectConstantsBuffer.GetName() == 0) {
+				uint32_t name;
+				glGenBuffers(1, &name);
+				objectConstantsBuffer = GpuResource(GpuResourceType::Buffer, name, sizeof(ObjectConstants));
+			}
+			GLStateCache::Instance().BindBuffer(GL_UNIFORM_BUFFER, objectConstantsBuffer.GetName());
+			// Orphans the previous constants rather than waiting for the GPU to finish with them
+			glBufferData(GL_UNIFORM_BUFFER, sizeof(ObjectConstants), &objectConstants, GL_STREAM_DRAW);
+			GLStateCache::Instance().BindBufferRange(GL_UNIFORM_BUFFER, OBJECT_CONSTANTS_BINDING, objectConstantsBuffer.GetName(), 0,
+				sizeof(ObjectConstants));
+		}
+
+		geometry.BindDrawData();
+		size_t commandOffset = 0;
+		if (context.multiDrawIndirect) {
+			commandOffset = geometry.UploadDrawCommands(sortedCommands);
+		}
+		shader.Set(uniforms.vertexPulling, context.vertexPulling);
+
+		for (size_t sliceIndex = 0; sliceIndex < sliceCount; sliceIndex++) {
+			const DrawSlice& slice = slices[sliceIndex];
+			slice.commandList.Replay(commandOffset);
+			lastDrawStats.drawCalls += slice.commandList.GetStats().drawCalls;
+			lastDrawStats.commandListBytes += slice.commandList.GetStats().bytes;
+			lastDrawStats.buckets += slice.stats.buckets;
+			lastDrawStats.vertexArrayBinds += slice.stats.vertexArrayBinds;
+		}
+
+		lastDrawStats.replayMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recorded).count();
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	lastDrawStats.submitMilliseconds = elapsed.count();
+}
+
+void Model::PrepareSlice(DrawSlice& slice, size_t begin, size_t end, const DrawContext& context, const MeshletCullData& cullData,
+	uint32_t programKey, size_t maxCommands) {
+	slice.commands.clear();
+	slice.keys.clear();
+	slice.stats = DrawStats();
+
+	glm::mat4 modelView = context.view * context.model;
+	for (size_t itemIndex = begin; itemIndex < end; itemIndex++) {
+		const DrawItem& item = drawItems[itemIndex];
+		const Mesh& mesh = meshes[item.meshIndex];
+		if (!mesh.IsDrawable()) {
+			activeLods[item.meshIndex] = 0;
+			continue;
+		}
+		uint32_t lod = context.enableLods ? SelectLod(mesh, context) : 0;
+		// Each mesh sits in exactly one slice, so slices never write the same element
+		activeLods[item.meshIndex] = lod;
+		size_t firstCommand = slice.commands.size();
+
+		// Coarser levels are already cheap, so only full detail is split into meshlets
+		bool split = false;
+		DrawStats statsBeforeSplit = slice.stats;
+		if (lod == 0 && context.cullMeshlets && mesh.HasMeshlets()) {
+			slice.stats.triangles += mesh.AppendMeshletDraws(cullData, slice.stats.meshlets, slice.commands);
+			split = true;
+		}
+		else if (context.cullSubmeshes && mesh.HasSubmeshes()) {
+			slice.stats.triangles += mesh.AppendSubmeshDraws(lod, cullData, slice.stats.submeshes, slice.commands);
+			split = true;
+		}
+
+		// Past the slice's share of the payload range, the rest of the slice's meshes draw whole, one command each
+		if (!split || slice.commands.size() + (end - itemIndex - 1) > maxCommands) {
+			if (split) {
+				slice.stats = statsBeforeSplit;
+				slice.commands.resize(firstCommand);
+			}
+			slice.stats.triangles += mesh.GetLod(lod).indexCount / 3;
+			mesh.AppendDraw(lod, slice.commands);
+		}
+
+		// Everything the model draws is opaque, so this sorts front to back within each bucket.
+		// The command index goes in the payload when the slices are merged; keys[i] belongs to commands[i].
+		float viewDepth = -(modelView * glm::vec4(mesh.GetBoundsCenter(), 1.f)).z;
+		uint64_t key = RenderKey::Make(0, false, programKey, buckets[item.bucketIndex].materialKey, viewDepth);
+		slice.keys.resize(slice.commands.size(), key);
+	}
+}
+
+void Model::RecordSlice(DrawSlice& slice, size_t begin, size_t end, const Shader& shader, const DrawContext& context) {
+	slice.commandList.Clear();
+	slice.stats.buckets = 0;
+	slice.stats.vertexArrayBinds = 0;
+	if (begin == end) {
+		return;
+	}
+
+	const SceneGeometry& geometry = SceneGeometry::Instance();
+	const std::vector<uint64_t>& entries = renderQueue.GetEntries();
+	const GeometryPool* boundPool = nullptr;
+	uint32_t boundBucket = UINT32_MAX;
+	size_t runStart = begin;
+
+	for (size_t i = begin; i <= end; i++) {
+		uint32_t bucketIndex = i < end ? materialBuckets[RenderKey::GetMaterial(entries[i])] : UINT32_MAX;
+		if (bucketIndex != boundBucket) {
+			// A bucket's commands are adjacent in sortedCommands, so each run in this slice is one multi-draw
+			if (boundBucket != UINT32_MAX && context.multiDrawIndirect) {
+				slice.commandList.MultiDrawElementsIndirect(boundPool->GetIndexType(), runStart * sizeof(DrawElementsIndirectCommand),
+					static_cast<uint32_t>(i - runStart));
+			}
+			if (i == end) {
+				break;
+			}
+
+			const DrawBucket& bucket = buckets[bucketIndex];
+			meshes[bucket.meshIndices[0]].RecordMaterial(slice.commandList, shader, uniforms);
+			if (bucket.pool != boundPool) {
+				if (context.vertexPulling) {
+					// Only the element buffer changes; the vertex array itself stays bound once the cache has it
+					geometry.RecordBindForVertexPulling(slice.commandList, *bucket.pool);
+					if (boundPool == nullptr) {
+						slice.stats.vertexArrayBinds++;
+					}
+				}
+				else {
+					bucket.pool->RecordBind(slice.commandList);
+					slice.stats.vertexArrayBinds++;
+				}
+				boundPool = bucket.pool;
+			}
+			boundBucket = bucketIndex;
+			runStart = i;
+			slice.stats.buckets++;
+		}
+
+		const DrawElementsIndirectCommand& command = drawCommands[RenderQueue::GetPayload(entries[i])];
+		sortedCommands[i] = command;
+		if (!context.multiDrawIndirect) {
+			slice.commandList.DrawElements(boundPool->GetIndexType(), command.count, static_cast<size_t>(command.firstIndex) * boundPool->GetIndexSize(),
+				command.baseVertex, command.baseInstance);
+		}
+	}
+}
+
+void Model::AddToBucket(uint32_t meshIndex, const std::vector<std::string>& textureNames) {
+	GeometryPool* pool = &meshes[meshIndex].GetPool();
+	for (DrawBucket& bucket : buckets) {
+		if (bucket.pool == pool && bucket.textureNames == textureNames) {
+			bucket.meshIndices.push_back(meshIndex);
+			return;
+		}
+	}
+
+	DrawBucket bucket;
+	bucket.pool = pool;
+	bucket.textureNames = textureNames;
+	bucket.meshIndices.push_back(meshIndex);
+	buckets.push_back(std::move(bucket));
+
+	// Only runs while loading, so renumbering every bucket each time is cheap enough
+	std::vector<uint32_t> order(buckets.size());
+	for (uint32_t i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+		return std::less<const GeometryPool*>()(buckets[a].pool, buckets[b].pool);
+	});
+	materialBuckets = order;
+	for (uint32_t materialKey = 0; materialKey < order.size(); materialKey++) {
+		buckets[order[materialKey]].materialKey = materialKey;
+	}
+	if (buckets.size() > (1u << RenderKey::MATERIAL_BITS)) {
+		std::cout << "ERROR: Model has more draw buckets than render keys can tell apart\n";
+	}
+}
+
+size_t Model::GetGeometryBytes() const {
+	size_t bytes = 0;
+	for (const Mesh& mesh : meshes) {
+		bytes += mesh.GetGpuBytes();
+	}
+	return bytes;
+}
+
+size_t Model::GetSourceMeshCount() const {
+	size_t count = 0;
+	for (const Mesh& mesh : meshes) {
+		count += mesh.GetSourceMeshCount();
 	}
+	return count;
 }
 
-void Model::ProcessNode(aiNode* node, const aiScene* scene) {
+size_t Model::GetCpuGeometryBytes() const {
+	size_t bytes = 0;
+	for (const Mesh& mesh : meshes) {
+		bytes += mesh.GetCpuBytes();
+	}
+	return bytes;
+}
+
+uint32_t Model::SelectLod(const Mesh& mesh, const DrawContext& context) {
+	if (mesh.GetLodCount() <= 1) {
+		return 0;
+	}
+
+	// Bounds move into view space; the radius grows with the largest axis scale of the model matrix
+	glm::vec4 viewCenter = context.view * context.model * glm::vec4(mesh.GetBoundsCenter(), 1.f);
+	float scale = glm::max(glm::length(glm::vec3(context.model[0])), glm::max(glm::length(glm::vec3(context.model[1])), glm::length(glm::vec3(context.model[2]))));
+	float radius = mesh.GetBoundsRadius() * scale;
+	float depth = -viewCenter.z;
+	if (depth <= radius) {
+		return 0;
+	}
+
+	// Screen pixels covered by one world unit at the bounds' depth
+	float pixelsPerUnit = context.projection[1][1] * context.viewportHeight / (2.f * depth);
+	for (uint32_t lod = mesh.GetLodCount() - 1; lod > 0; lod--) {
+		if (mesh.GetLod(lod).error * radius * pixelsPerUnit <= context.maxErrorPixels) {
+			return lod;
+		}
+	}
+	return 0;
+}
+
+bool Model::Import(const std::string& path, const ImportOptions& options, ModelData& data, LoadStatus* status) {
+	data.directory = path.substr(0, path.find_last_of('\\'));
+	data.compactVertices = options.compactVertices;
+	data.cpuGeometry = options.cpuGeometry;
+
+	auto start = std::chrono::steady_clock::now();
+	data.cacheHit = LoadFromCache(path, options, data);
+	if (!data.cacheHit && !LoadFromFile(path, options, data, status)) {
+		return false;
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	if (status != nullptr) {
+		status->importProgress = 0.5f;
+	}
+
+	MeshCache::RecordLoad(data.cacheHit, elapsed.count());
+	std::cout << "MESH CACHE: " << (data.cacheHit ? "hit" : "miss") << " for " << path << ", loaded in " << elapsed.count() << " ms\n";
+
+	DecodeTextures(data, options.flipTextures, status);
+	return !IsCancelled(status);
+}
+
+void Model::StageUploads(ModelData& data, LoadStatus* status) {
+	data.stagedTextures.resize(data.textureImages.size());
+	for (size_t i = 0; i < data.textureImages.size() && !IsCancelled(status); i++) {
+		// Resident textures decoded no pixels and are taken from the cache instead
+		if (data.textureImages[i].pixels) {
+			data.stagedTextures[i] = Texture::Stage(data.textureImages[i]);
+			data.textureImages[i].pixels.reset();
+		}
+	}
+
+	data.stagedMeshes.reserve(data.meshes.size());
+	for (size_t i = 0; i < data.meshes.size() && !IsCancelled(status); i++) {
+		data.stagedMeshes.push_back(Mesh::Stage(data.meshes[i], data.compactVertices));
+	}
+}
+
+void Model::DiscardStaged(ModelData& data) {
+	for (StagedTexture& staged : data.stagedTextures) {
+		Texture::DiscardStaged(staged);
+	}
+	for (StagedGeometry& staged : data.stagedMeshes) {
+		Mesh::DiscardStaged(staged);
+	}
+}
+
+bool Model::UploadNext(ModelData& data, size_t* uploadedBytes) {
+	if (uploadedBytes != nullptr) {
+		*uploadedBytes = 0;
+	}
+
+	// Textures go first so meshes can reference them once they are uploaded
+	size_t textureIndex = loadedTextures.size();
+	if (textureIndex < data.textureImages.size()) {
+		StagedTexture* staged = textureIndex < data.stagedTextures.size() ? &data.stagedTextures[textureIndex] : nullptr;
+		// Adopting a staged texture costs this thread nothing; a cache hit neither
+		const TextureImage& image = data.textureImages[textureIndex];
+		if (uploadedBytes != nullptr && image.pixels) {
+			*uploadedBytes = Texture::EstimateBytes(image.width, image.height);
+		}
+		Texture texture = TextureCache::Instance().Acquire(data.textureSources[textureIndex], image, staged);
+		texture.SetFileName(data.textureNames[textureIndex]);
+		textureLookup[data.textureNames[textureIndex]] = loadedTextures.size();
+		loadedTextures.push_back(texture);
+		data.textureImages[textureIndex].pixels.reset();
+		return GetUploadedItemCount() == GetUploadItemCount(data);
+	}
+
+	if (meshes.empty() && data.optimized) {
+		hasOptimizationReport = true;
+		optimizationReport = data.optimization;
+	}
+
+	size_t meshIndex = meshes.size();
+	if (meshIndex < data.meshes.size()) {
+		meshes.reserve(data.meshes.size());
+		const MeshView& mesh = data.meshes[meshIndex];
+		std::vector<Texture> textures = LoadMaterialTextures(mesh.diffuseTextures);
+		StagedGeometry* staged = meshIndex < data.stagedMeshes.size() && data.stagedMeshes[meshIndex].buffer != 0
+			? &data.stagedMeshes[meshIndex] : nullptr;
+		// Freshly imported geometry is handed over; cached geometry is only mapped, so it is copied if kept
+		if (meshIndex < data.converted.size()) {
+			meshes.emplace_back(std::move(data.converted[meshIndex]), std::move(textures), data.compactVertices, data.cpuGeometry, staged);
+		}
+		else {
+			meshes.emplace_back(mesh, std::move(textures), data.compactVertices, data.cpuGeometry, staged);
+		}
+		if (staged != nullptr) {
+			// The mesh queued the staging buffer for deletion after its copy
+			staged->buffer = 0;
+		}
+		if (uploadedBytes != nullptr) {
+			// A staged mesh is a GPU-side copy, which still occupies the frame
+			*uploadedBytes = meshes.back().GetGpuBytes();
+		}
+		AddToBucket(static_cast<uint32_t>(meshIndex), mesh.diffuseTextures);
+	}
+
+	return GetUploadedItemCount() == GetUploadItemCount(data);
+}
+
+bool Model::LoadFromCache(const std::string& path, const ImportOptions& options, ModelData& data) {
+	if (!MeshCache::Load(path, IMPORT_FLAGS, options.GetPipelineFlags(), data.cached)) {
+		return false;
+	}
+
+	data.meshes = data.cached.meshes;
+	return true;
+}
+
+bool Model::LoadFromFile(const std::string& path, const ImportOptions& options, ModelData& data, LoadStatus* status) {
+	std::vector<MeshData>& meshData = data.converted;
+
+	// OBJ files take the native parser; Assimp handles everything else and any OBJ the parser rejects
+	// Material libraries are listed even when the parser gives up, since Assimp reads the same ones
+	std::vector<std::string> dependencies;
+	bool loaded = IsObjFile(path) && ObjLoader::Load(path, meshData, &dependencies);
+	if (!loaded && !ImportWithAssimp(path, meshData, status)) {
+		return false;
+	}
+
+	if (IsCancelled(status)) {
+		return false;
+	}
+
+	if (options.optimizeMeshes) {
+		std::vector<OptimizationReport> reports(meshData.size());
+		ThreadPool::Shared().ParallelFor(meshData.size(), [&](size_t i) {
+			reports[i] = MeshOptimizer::Optimize(meshData[i]);
+		});
+
+		for (const OptimizationReport& report : reports) {
+			data.optimization.Merge(report);
+		}
+		data.optimized = true;
+		std::cout << "MESH OPTIMIZER: ACMR " << data.optimization.before.acmr << " -> " << data.optimization.after.acmr
+			<< ", ATVR " << data.optimization.before.atvr << " -> " << data.optimization.after.atvr
+			<< ", vertices " << data.optimization.verticesBefore << " -> " << data.optimization.verticesAfter << "\n";
+	}
+
+	// Meshlets regroup the full-detail triangles, so they are built before LODs are appended
+	if (options.buildMeshlets) {
+		ThreadPool::Shared().ParallelFor(meshData.size(), [&](size_t i) {
+			Meshlets::Build(meshData[i]);
+		});
+	}
+
+	if (options.generateLods) {
+		ThreadPool::Shared().ParallelFor(meshData.size(), [&](size_t i) {
+			MeshSimplifier::GenerateLods(meshData[i], options.lodSettings, options.optimizeMeshes);
+		});
+
+		size_t levels = 0;
+		for (const MeshData& mesh : meshData) {
+			levels += mesh.lods.size();
+		}
+		std::cout << "MESH SIMPLIFIER: " << levels << " levels across " << meshData.size() << " meshes\n";
+	}
+
+	ThreadPool::Shared().ParallelFor(meshData.size(), [&](size_t i) {
+		FinalizeMeshData(meshData[i]);
+	});
+
+	// Last, so every member brings its own levels, meshlets and bounds along
+	if (options.batchMeshes) {
+		BatchReport report = MeshBatcher::Batch(meshData, options.maxBatchVertices);
+		std::cout << "MESH BATCHER: " << report.meshesBefore << " meshes -> " << report.meshesAfter << " batches\n";
+	}
+
+	if (!MeshCache::Store(path, IMPORT_FLAGS, options.GetPipelineFlags(), meshData, dependencies)) {
+		std::cout << "ERROR: Could not store mesh cache for " << path << "\n";
+	}
+
+	data.meshes.reserve(meshData.size());
+	for (const MeshData& mesh : meshData) {
+		data.meshes.push_back(GetMeshView(mesh));
+	}
+
+	return true;
+}
+
+bool Model::ImportWithAssimp(const std::string& path, std::vector<MeshData>& meshData, LoadStatus* status) {
+	Assimp::Importer importer;
+
+	const aiScene* scene = importer.ReadFile(path, IMPORT_FLAGS);
+	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+		std::cout << "ASSIMP ERROR: " << importer.GetErrorString() << "\n";
+		return false;
+	}
+
+	std::vector<SceneMesh> sceneMeshes;
+	ProcessNode(scene->mRootNode, scene, aiMatrix4x4(), sceneMeshes);
+
+	// Convert every mesh in parallel; results land in their flattened slot so the order stays deterministic
+	meshData.resize(sceneMeshes.size());
+	std::atomic<size_t> convertedCount{ 0 };
+	ThreadPool::Shared().ParallelFor(sceneMeshes.size(), [&](size_t i) {
+		if (IsCancelled(status)) {
+			return;
+		}
+		meshData[i] = ProcessMesh(sceneMeshes[i], scene);
+		if (status != nullptr) {
+			status->importProgress = 0.5f * (convertedCount.fetch_add(1) + 1) / sceneMeshes.size();
+		}
+	});
+
+	return true;
+}
+
+void Model::ProcessNode(const aiNode* node, const aiScene* scene, const aiMatrix4x4& parentTransform, std::vector<SceneMesh>& sceneMeshes) {
+	aiMatrix4x4 transform = parentTransform * node->mTransformation;
 	for (int i = 0; i < node->mNumMeshes; i++) {
-		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		meshes.push_back(ProcessMesh(mesh, scene));
+		sceneMeshes.push_back(SceneMesh{ scene->mMeshes[node->mMeshes[i]], transform });
 	}
 
 	for (int i = 0; i < node->mNumChildren; i++) {
-		ProcessNode(node->mChildren[i], scene);
+		ProcessNode(node->mChildren[i], scene, transform, sceneMeshes);
 	}
 }
 
-Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene) {
-	std::vector<Vertex> vertices;
-	std::vector<uint32_t> indices;
-	std::vector<Texture> textures;
+MeshData Model::ProcessMesh(const SceneMesh& sceneMesh, const aiScene* scene) {
+	const aiMesh* mesh = sceneMesh.mesh;
+	MeshData data;
 
+	bool transformed = !sceneMesh.transform.IsIdentity();
+	aiMatrix3x3 normalTransform = aiMatrix3x3(sceneMesh.transform);
+	normalTransform.Inverse().Transpose();
+
+	data.vertices.resize(mesh->mNumVertices);
 	for (int i = 0; i < mesh->mNumVertices; i++) {
-		Vertex vertex;
+		Vertex& vertex = data.vertices[i];
 
-		vertex.Position.x = mesh->mVertices[i].x;
-		vertex.Position.y = mesh->mVertices[i].y;
-		vertex.Position.z = mesh->mVertices[i].z;
+		aiVector3D position = transformed ? sceneMesh.transform * mesh->mVertices[i] : mesh->mVertices[i];
+		vertex.Position.x = position.x;
+		vertex.Position.y = position.y;
+		vertex.Position.z = position.z;
 
-		vertex.Normal.x = mesh->mNormals[i].x;
-		vertex.Normal.y = mesh->mNormals[i].y;
-		vertex.Normal.z = mesh->mNormals[i].z;
+		aiVector3D normal = transformed ? (normalTransform * mesh->mNormals[i]).NormalizeSafe() : mesh->mNormals[i];
+		vertex.Normal.x = normal.x;
+		vertex.Normal.y = normal.y;
+		vertex.Normal.z = normal.z;
 		
 		if (mesh->mTextureCoords[0]) {
 			vertex.TexCoords.x = mesh->mTextureCoords[0][i].x;
@@ -60,47 +671,76 @@ Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene) {
 		else {
 			vertex.TexCoords = glm::vec2(0.f, 0.f);
 		}
-
-		vertices.push_back(vertex);
 	}
 
+	// A mirroring transform turns baked faces inside out, so their winding is reversed to keep them front facing
+	bool mirrored = transformed && sceneMesh.transform.Determinant() < 0.f;
+
+	// Triangulated, so nearly every face has three indices
+	data.indices.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
 	for (int i = 0; i < mesh->mNumFaces; i++) {
-		aiFace face = mesh->mFaces[i];
+		const aiFace& face = mesh->mFaces[i];
 		for (int j = 0; j < face.mNumIndices; j++) {
-			indices.push_back(face.mIndices[j]);
+			data.indices.push_back(face.mIndices[mirrored ? face.mNumIndices - 1 - j : j]);
 		}
 	}
 	
 	if (mesh->mMaterialIndex >= 0) {
-		aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-		textures = LoadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
+		const aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+		for (int i = 0; i < material->GetTextureCount(aiTextureType_DIFFUSE); i++) {
+			aiString name;
+			material->GetTexture(aiTextureType_DIFFUSE, i, &name);
+			data.diffuseTextures.push_back(name.C_Str());
+		}
 	}
-	return Mesh(vertices, indices, textures);
+	return data;
 }
 
-std::vector<Texture> Model::LoadMaterialTextures(aiMaterial* material, aiTextureType type, const char* typeName) {
-	std::vector<Texture> textures;
-	for (int i = 0; i < material->GetTextureCount(type); i++) {
-		aiString name;
-		material->GetTexture(type, i, &name);
-		
-		// Check if texture was already loaded
-		bool skip = false;
-		for (const Texture& loadedTexture : loadedTextures) {
-			if (std::strcmp(loadedTexture.GetFileName().data(), name.C_Str()) == 0) {
-				textures.push_back(loadedTexture);
-				skip = true;
-				break;
+void Model::DecodeTextures(ModelData& data, bool flipTextures, LoadStatus* status) {
+	for (const MeshView& mesh : data.meshes) {
+		for (const std::string& name : mesh.diffuseTextures) {
+			bool known = false;
+			for (const std::string& textureName : data.textureNames) {
+				if (textureName == name) {
+					known = true;
+					break;
+				}
+			}
+			if (!known) {
+				data.textureNames.push_back(name);
 			}
 		}
-		
-		// Texture not loaded, load it
-		if (!skip) {
-			std::string texturePath = directory + '/' + name.C_Str();
-			Texture texture(texturePath.c_str(), flipTextures);
-			texture.SetFileName(name.C_Str());
-			textures.push_back(texture);
-			loadedTextures.push_back(texture);
+	}
+
+	// Every texture is read, hashed and decoded on its own worker; only the upload waits for the GL thread
+	data.textureSources.resize(data.textureNames.size());
+	data.textureImages.resize(data.textureNames.size());
+	std::atomic<size_t> decodedCount{ 0 };
+	ThreadPool::Shared().ParallelFor(data.textureNames.size(), [&](size_t i) {
+		if (IsCancelled(status)) {
+			return;
+		}
+
+		// Textures another model already uploaded are shared instead of decoded again
+		std::string texturePath = data.directory + '/' + data.textureNames[i];
+		TextureSource& source = data.textureSources[i];
+		if (TextureCache::ReadSource(texturePath, flipTextures, source) && !TextureCache::Instance().Contains(source)) {
+			Texture::DecodeMemory(source.bytes.data(), source.bytes.size(), flipTextures, data.textureImages[i]);
+		}
+		source.bytes = std::vector<unsigned char>();
+		if (status != nullptr) {
+			status->importProgress = 0.5f + 0.5f * (decodedCount.fetch_add(1) + 1) / data.textureNames.size();
+		}
+	});
+}
+
+std::vector<Texture> Model::LoadMaterialTextures(const std::vector<std::string>& textureNames) {
+	std::vector<Texture> textures;
+	for (const std::string& name : textureNames) {
+		// Textures were uploaded ahead of the meshes, so this only looks them up
+		auto found = textureLookup.find(name);
+		if (found != textureLookup.end()) {
+			textures.push_back(loadedTextures[found->second]);
 		}
 	}
 	
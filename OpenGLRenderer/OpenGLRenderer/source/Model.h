@@ -4,27 +4,242 @@
 
 #include "Shader.h"
 #include "Mesh.h"
+#include "MeshCache.h"
+#include "TextureCache.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshBatcher.h"
+#include "RenderQueue.h"
 
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <atomic>
+
+// Shared between a background load and the thread that started it
+struct LoadStatus {
+	std::atomic<bool> cancelRequested{ false };
+	std::atomic<float> importProgress{ 0.f };
+};
+
+// Choices that change what Import produces; pipeline stages that alter geometry also key the mesh cache
+struct ImportOptions {
+	bool flipTextures = true;
+	bool optimizeMeshes = false;
+	bool generateLods = false;
+	bool buildMeshlets = false;
+	// Merges meshes sharing a texture set; the vertex limit is not part of the cache key, like lodSettings
+	bool batchMeshes = false;
+	uint32_t maxBatchVertices = MeshBatcher::DEFAULT_MAX_VERTICES;
+	// Upload-time only, so it does not key the mesh cache
+	bool compactVertices = false;
+	CpuGeometryPolicy cpuGeometry = CpuGeometryPolicy::Drop;
+	LodSettings lodSettings;
+
+	uint32_t GetPipelineFlags() const;
+};
+
+// Per-frame inputs for picking each mesh's level of detail
+struct DrawContext {
+	// Streamed to the shader through the ring buffer with the rest of the per-object constants
+	glm::mat4 model = glm::mat4(1.f);
+	glm::mat4 view = glm::mat4(1.f);
+	glm::mat4 projection = glm::mat4(1.f);
+	float viewportHeight = 1.f;
+	// Largest simplification error allowed on screen, in pixels
+	float maxErrorPixels = 1.f;
+	bool enableLods = true;
+	// Skips off-screen and back-facing meshlets of meshes drawn at full detail
+	bool cullMeshlets = true;
+	// Skips off-screen parts of static batches wherever meshlets are not used
+	bool cullSubmeshes = true;
+	// One glMultiDrawElementsIndirect per bucket instead of one draw call per command
+	bool multiDrawIndirect = true;
+	// Shader fetches vertices from storage buffers through one shared vertex array instead of per-pool attribute setups
+	bool vertexPulling = false;
+	// Culls, builds and records large models on the worker pool in slices; the GL thread only replays
+	bool parallelRecording = true;
+};
+
+struct DrawStats {
+	MeshletCullStats meshlets;
+	SubmeshCullStats submeshes;
+	size_t triangles = 0;
+	uint32_t commands = 0;
+	uint32_t buckets = 0;
+	uint32_t drawCalls = 0;
+	uint32_t vertexArrayBinds = 0;
+	RenderQueueStats queue;
+	uint32_t recordingSlices = 0;
+	size_t commandListBytes = 0;
+	// Culling, level selection and sorting; recording into command lists; replaying them on the GL thread
+	double prepareMilliseconds = 0.0;
+	double recordMilliseconds = 0.0;
+	double replayMilliseconds = 0.0;
+	double submitMilliseconds = 0.0;
+};
+
+// Everything a Model needs that can be produced off the GL thread
+struct ModelData {
+	std::string directory;
+	bool cacheHit = false;
+	bool optimized = false;
+	bool compactVertices = false;
+	CpuGeometryPolicy cpuGeometry = CpuGeometryPolicy::Drop;
+	OptimizationReport optimization;
+
+	CachedModel cached;
+	// Handed to the meshes one by one during upload, which leaves the matching views dangling
+	std::vector<MeshData> converted;
+	std::vector<MeshView> meshes;
+
+	// Unique textures in first-use order; images stay empty for textures the cache already holds
+	std::vector<std::string> textureNames;
+	std::vector<TextureSource> textureSources;
+	std::vector<TextureImage> textureImages;
+
+	// Filled on the upload context when it is running, then adopted by UploadNext in place of uploading
+	std::vector<StagedTexture> stagedTextures;
+	std::vector<StagedGeometry> stagedMeshes;
+};
 
 class Model {
 public:
-	Model(const std::string& path, bool flipTextures = true);
+	Model() = default;
+
+	Model(const std::string& path, const ImportOptions& options = ImportOptions());
+
+	// Returns this model's geometry and its references to shared textures
+	~Model();
+
+	Model(const Model&) = delete;
+	Model& operator=(const Model&) = delete;
 
 	void Draw(const Shader& shader);
 
+	// Draws each mesh at the coarsest level whose projected error stays under context.maxErrorPixels
+	void Draw(const Shader& shader, const DrawContext& context);
+
+	// Loads geometry and decodes textures without any GL calls; returns false on failure or cancellation
+	static bool Import(const std::string& path, const ImportOptions& options, ModelData& data, LoadStatus* status = nullptr);
+
+	// Uploads one texture or mesh from data, or adopts its staged copy; returns true once everything has been uploaded.
+	// uploadedBytes receives the GPU memory the item filled on this thread.
+	bool UploadNext(ModelData& data, size_t* uploadedBytes = nullptr);
+
+	// Creates every texture and mesh buffer of data ahead of UploadNext; runs on the upload context.
+	// Stops early on cancellation, leaving the rest to be uploaded as usual.
+	static void StageUploads(ModelData& data, LoadStatus* status = nullptr);
+
+	// Deletes whatever StageUploads made that UploadNext has not adopted
+	static void DiscardStaged(ModelData& data);
+
+	static size_t GetUploadItemCount(const ModelData& data) { return data.textureImages.size() + data.meshes.size(); }
+
+	size_t GetUploadedItemCount() const { return loadedTextures.size() + meshes.size(); }
+
+	// Only set when this load ran the optimizer; cache hits reuse already optimized geometry
+	bool HasOptimizationReport() const { return hasOptimizationReport; }
+
+	const OptimizationReport& GetOptimizationReport() const { return optimizationReport; }
+
+	// Vertex and index memory of all meshes on the GPU
+	size_t GetGeometryBytes() const;
+
+	// Memory the meshes hold outside the GPU, see Mesh::GetCpuBytes
+	size_t GetCpuGeometryBytes() const;
+
+	size_t GetMeshCount() const { return meshes.size(); }
+
+	const Mesh& GetMesh(size_t meshIndex) const { return meshes[meshIndex]; }
+
+	// Meshes the model had before static batching merged them
+	size_t GetSourceMeshCount() const;
+
+	// Level each mesh was drawn with by the last Draw call
+	uint32_t GetActiveLod(size_t meshIndex) const { return meshIndex < activeLods.size() ? activeLods[meshIndex] : 0; }
+
+	const DrawStats& GetLastDrawStats() const { return lastDrawStats; }
+
 private:
+	struct SceneMesh {
+		const aiMesh* mesh;
+		aiMatrix4x4 transform;
+	};
+
+	// Meshes sharing a geometry pool and textures, drawn together with one state change
+	struct DrawBucket {
+		GeometryPool* pool = nullptr;
+		std::vector<std::string> textureNames;
+		std::vector<uint32_t> meshIndices;
+		// Material field of the render keys; ordered by pool so buckets sharing one sort next to each other
+		uint32_t materialKey = 0;
+	};
+
+	struct DrawItem {
+		uint32_t bucketIndex;
+		uint32_t meshIndex;
+	};
+
+	// One worker's share of a frame: the draw items it prepares, then the sorted commands it records
+	struct DrawSlice {
+		std::vector<DrawElementsIndirectCommand> commands;
+		// Render key of each command, without a payload
+		std::vector<uint64_t> keys;
+		DrawStats stats;
+		CommandList commandList;
+	};
+
 	std::vector<Mesh> meshes;
 	std::vector<Texture> loadedTextures;
+	std::unordered_map<std::string, size_t> textureLookup;
 
-	std::string directory;
+	bool hasOptimizationReport = false;
+	OptimizationReport optimizationReport;
+
+	std::vector<uint32_t> activeLods;
+	DrawStats lastDrawStats;
+	std::vector<DrawBucket> buckets;
+	std::vector<DrawElementsIndirectCommand> drawCommands;
+	RenderQueue renderQueue;
+	std::vector<DrawElementsIndirectCommand> sortedCommands;
+	std::vector<DrawItem> drawItems;
+	std::vector<DrawSlice> slices;
+	// Bucket index by material key
+	std::vector<uint32_t> materialBuckets;
+	// Holds ObjectConstants on frames the ring buffer is full
+	GpuResource objectConstantsBuffer;
+
+	// Resolved again only when Draw is handed a different program
+	uint32_t uniformsProgram = 0;
+	MeshUniforms uniforms;
+
+	void AddToBucket(uint32_t meshIndex, const std::vector<std::string>& textureNames);
+
+	// Culls and picks levels for drawItems[begin, end), appending commands and keys to slice; meshes that would
+	// take the slice past maxCommands are drawn whole instead of split into meshlets or submeshes
+	void PrepareSlice(DrawSlice& slice, size_t begin, size_t end, const DrawContext& context, const MeshletCullData& cullData,
+		uint32_t programKey, size_t maxCommands);
+
+	// Records the sorted entries [begin, end), also writing their commands into sortedCommands at the same positions
+	void RecordSlice(DrawSlice& slice, size_t begin, size_t end, const Shader& shader, const DrawContext& context);
+
+	static uint32_t SelectLod(const Mesh& mesh, const DrawContext& context);
+
+	static bool LoadFromCache(const std::string& path, const ImportOptions& options, ModelData& data);
+
+	static bool LoadFromFile(const std::string& path, const ImportOptions& options, ModelData& data, LoadStatus* status);
+
+	static bool ImportWithAssimp(const std::string& path, std::vector<MeshData>& meshData, LoadStatus* status);
 
-	bool flipTextures;
+	// Flattens the node tree into depth-first mesh order, accumulating node transforms
+	static void ProcessNode(const aiNode* node, const aiScene* scene, const aiMatrix4x4& parentTransform, std::vector<SceneMesh>& sceneMeshes);
 
-	void ProcessNode(aiNode* node, const aiScene* scene);
+	// Touches no model state, so it is run for many meshes at once on the worker pool.
+	// Bakes the node transform in, so meshes from different nodes can share a batch.
+	static MeshData ProcessMesh(const SceneMesh& sceneMesh, const aiScene* scene);
 
-	Mesh ProcessMesh(aiMesh* mesh, const aiScene* scene);
+	static void DecodeTextures(ModelData& data, bool flipTextures, LoadStatus* status);
 
-	std::vector<Texture> LoadMaterialTextures(aiMaterial* material, aiTextureType type, const char* typeName);
+	std::vector<Texture> LoadMaterialTextures(const std::vector<std::string>& textureNames);
 };
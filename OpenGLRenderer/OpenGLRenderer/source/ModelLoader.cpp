@@ -0,0 +1,160 @@
+#include "ModelLoader.h"
+#include "ThreadPool.h"
+#include "ProcessMemory.h"
+
+#include <chrono>
+#include <iostream>
+
+ModelLoader::~ModelLoader() {
+	Shutdown();
+}
+
+void ModelLoader::Start(const std::string& path, const ImportOptions& options) {
+	Cancel();
+	Reset();
+
+	status = std::make_shared<LoadStatus>();
+	data = std::make_shared<ModelData>();
+	maxSliceMilliseconds = 0.0;
+
+	// The task holds its own references so an abandoned load can finish safely in the background
+	std::shared_ptr<LoadStatus> taskStatus = status;
+	std::shared_ptr<ModelData> taskData = data;
+	importResult = ThreadPool::Shared().Submit([path, options, taskStatus, taskData]() {
+		return Model::Import(path, options, *taskData, taskStatus.get());
+	});
+	stage = Stage::Importing;
+}
+
+void ModelLoader::Cancel() {
+	if (status) {
+		status->cancelRequested = true;
+	}
+}
+
+void ModelLoader::Shutdown() {
+	Cancel();
+	if (importResult.valid()) {
+		importResult.wait();
+	}
+	Reset();
+}
+
+Model* ModelLoader::Update(const UploadBudget& budget) {
+	lastSliceMilliseconds = 0.0;
+	lastSliceBytes = 0;
+	if (stage == Stage::Idle) {
+		return nullptr;
+	}
+
+	if (status->cancelRequested) {
+		// Partially uploaded GL objects are dropped with the model; an unfinished import winds down on its own
+		std::cout << "Model load cancelled\n";
+		Reset();
+		return nullptr;
+	}
+
+	if (stage == Stage::Importing) {
+		if (importResult.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			return nullptr;
+		}
+		if (!importResult.get()) {
+			std::cout << "ERROR: Model load failed\n";
+			Reset();
+			return nullptr;
+		}
+		model = std::make_unique<Model>();
+		stage = Stage::Uploading;
+
+		if (UploadContext::Instance().IsRunning()) {
+			std::shared_ptr<LoadStatus> taskStatus = status;
+			std::shared_ptr<ModelData> taskData = data;
+			stagingTicket = UploadContext::Instance().Submit([taskStatus, taskData]() {
+				Model::StageUploads(*taskData, taskStatus.get());
+			});
+			stage = Stage::Staging;
+		}
+	}
+
+	if (stage == Stage::Staging) {
+		// The fence covers the staged uploads, so adopting them is safe from here on
+		if (!stagingTicket->IsComplete()) {
+			return nullptr;
+		}
+		stage = Stage::Uploading;
+	}
+
+	// Always upload at least one item so a tiny budget still makes progress
+	auto start = std::chrono::steady_clock::now();
+	bool finished = false;
+	std::chrono::duration<double, std::milli> elapsed(0.0);
+	do {
+		size_t itemBytes = 0;
+		finished = model->UploadNext(*data, &itemBytes);
+		lastSliceBytes += itemBytes;
+		elapsed = std::chrono::steady_clock::now() - start;
+	} while (!finished && elapsed.count() < budget.milliseconds && lastSliceBytes < budget.bytes);
+
+	lastSliceMilliseconds = elapsed.count();
+	if (lastSliceMilliseconds > maxSliceMilliseconds) {
+		maxSliceMilliseconds = lastSliceMilliseconds;
+	}
+
+	if (!finished) {
+		return nullptr;
+	}
+
+	Model* loaded = model.release();
+	Reset();
+
+	// Taken after the import data is gone, so this is what the model costs to keep around
+	ProcessMemory memory = ProcessMemory::Query();
+	std::cout << "MODEL MEMORY: CPU geometry " << loaded->GetCpuGeometryBytes() / (1024.0 * 1024.0) << " MB, GPU geometry "
+		<< loaded->GetGeometryBytes() / (1024.0 * 1024.0) << " MB, RSS " << memory.residentBytes / (1024.0 * 1024.0)
+		<< " MB, peak RSS " << memory.peakResidentBytes / (1024.0 * 1024.0) << " MB\n";
+	return loaded;
+}
+
+float ModelLoader::GetProgress() const {
+	if (stage == Stage::Importing) {
+		return 0.5f * status->importProgress;
+	}
+	if (stage == Stage::Staging) {
+		return 0.5f;
+	}
+	if (stage == Stage::Uploading) {
+		size_t total = Model::GetUploadItemCount(*data);
+		return total == 0 ? 1.f : 0.5f + 0.5f * model->GetUploadedItemCount() / total;
+	}
+	return 0.f;
+}
+
+const char* ModelLoader::GetStageName() const {
+	switch (stage) {
+	case Stage::Importing:
+		return "Importing";
+	case Stage::Staging:
+		return "Staging";
+	case Stage::Uploading:
+		return "Uploading";
+	default:
+		return "Idle";
+	}
+}
+
+void ModelLoader::Reset() {
+	if (stagingTicket) {
+		// Queued behind the staging job, so it also catches objects that job is still creating
+		std::shared_ptr<ModelData> taskData = data;
+		UploadContext::Instance().Submit([taskData]() {
+			Model::DiscardStaged(*taskData);
+		});
+		stagingTicket.reset();
+	}
+
+	stage = Stage::Idle;
+	status.reset();
+	data.reset();
+	model.reset();
+	importResult = std::future<bool>();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Model.h"
+#include "UploadContext.h"
+
+#include <memory>
+#include <future>
+#include <string>
+
+// How much upload work the render thread may take on per frame; at least one item always goes through
+struct UploadBudget {
+	double milliseconds = 4.0;
+	size_t bytes = 32 * 1024 * 1024;
+};
+
+// Loads a model in the background: import and texture decoding on the worker pool,
+// then texture and buffer creation on the upload context when it is running,
+// then uploads or adoption on the render thread in slices that fit a per-frame budget
+class ModelLoader {
+public:
+	~ModelLoader();
+
+	// Starts a new load, abandoning any load already in flight
+	void Start(const std::string& path, const ImportOptions& options);
+
+	// Requests cancellation; the load is dropped on the next Update
+	void Cancel();
+
+	// Cancels, waits for the background import and frees any partial model; call before the GL context goes away
+	void Shutdown();
+
+	// Call once per frame on the GL thread; returns the finished model once, otherwise nullptr
+	Model* Update(const UploadBudget& budget);
+
+	bool IsBusy() const { return stage != Stage::Idle; }
+
+	// 0 to 1 across import and upload
+	float GetProgress() const;
+
+	const char* GetStageName() const;
+
+	double GetLastSliceMilliseconds() const { return lastSliceMilliseconds; }
+
+	double GetMaxSliceMilliseconds() const { return maxSliceMilliseconds; }
+
+	size_t GetLastSliceBytes() const { return lastSliceBytes; }
+
+private:
+	enum class Stage {
+		Idle,
+		Importing,
+		Staging,
+		Uploading
+	};
+
+	Stage stage = Stage::Idle;
+	std::shared_ptr<LoadStatus> status;
+	std::shared_ptr<ModelData> data;
+	std::future<bool> importResult;
+	std::shared_ptr<UploadTicket> stagingTicket;
+	std::unique_ptr<Model> model;
+
+	double lastSliceMilliseconds = 0.0;
+	double maxSliceMilliseconds = 0.0;
+	size_t lastSliceBytes = 0;
+
+	void Reset();
+};
@@ -0,0 +1,669 @@
+#include "ObjLoader.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+#include <unordered_map>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <string_view>
+
+namespace {
+	constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+
+	// The corner has no such attribute
+	constexpr int32_t NO_INDEX = -1;
+	// The file gave an index of 0 or one counting back past the first element
+	constexpr int32_t INVALID_INDEX = -2;
+
+	// Zero-based indices into the file-wide arrays, or NO_INDEX or INVALID_INDEX
+	struct ObjIndex {
+		int32_t position;
+		int32_t texCoord;
+		int32_t normal;
+
+		bool operator==(const ObjIndex& other) const {
+			return position == other.position && texCoord == other.texCoord && normal == other.normal;
+		}
+	};
+
+	size_t HashIndex(const ObjIndex& index) {
+		uint64_t hash = static_cast<uint32_t>(index.position);
+		hash = hash * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(index.texCoord);
+		hash = hash * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(index.normal);
+		return static_cast<size_t>(hash ^ (hash >> 29));
+	}
+
+	// Open-addressing map from OBJ corner to output vertex; far cheaper than unordered_map at millions of corners
+	class VertexLookup {
+	public:
+		explicit VertexLookup(size_t expectedCount) {
+			size_t capacity = 16;
+			while (capacity < expectedCount * 2) {
+				capacity *= 2;
+			}
+			slots.resize(capacity, Slot{ { -1, -1, -1 }, 0 });
+			mask = capacity - 1;
+		}
+
+		// Returns the existing vertex for index, or records newVertex and sets inserted
+		uint32_t FindOrInsert(const ObjIndex& index, uint32_t newVertex, bool& inserted) {
+			size_t slot = HashIndex(index) & mask;
+			while (true) {
+				Slot& entry = slots[slot];
+				if (entry.key.position < 0) {
+					entry.key = index;
+					entry.vertex = newVertex;
+					inserted = true;
+					return newVertex;
+				}
+				if (entry.key == index) {
+					inserted = false;
+					return entry.vertex;
+				}
+				slot = (slot + 1) & mask;
+			}
+		}
+
+	private:
+		struct Slot {
+			ObjIndex key;
+			uint32_t vertex;
+		};
+
+		std::vector<Slot> slots;
+		size_t mask = 0;
+	};
+
+	// Triangle corners that share a group and material
+	struct FaceRun {
+		std::string group;
+		std::string material;
+		std::vector<ObjIndex> corners;
+	};
+
+	struct ObjChunk {
+		const char* begin = nullptr;
+		const char* end = nullptr;
+
+		// First pass
+		uint32_t positionCount = 0;
+		uint32_t texCoordCount = 0;
+		uint32_t normalCount = 0;
+		bool setsGroup = false;
+		bool setsMaterial = false;
+		// Views into the mapped file, which outlives both passes
+		std::string_view lastGroup;
+		std::string_view lastMaterial;
+		std::vector<std::string> materialLibraries;
+
+		// Second pass
+		uint32_t positionBase = 0;
+		uint32_t texCoordBase = 0;
+		uint32_t normalBase = 0;
+		std::string startGroup;
+		std::string startMaterial;
+		std::vector<FaceRun> runs;
+		bool valid = true;
+	};
+
+	const double POWERS_OF_TEN[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20
+	};
+
+	bool IsSpace(char c) {
+		return c == ' ' || c == '\t';
+	}
+
+	bool IsDigit(char c) {
+		return c >= '0' && c <= '9';
+	}
+
+	const char* SkipSpaces(const char* cursor, const char* end) {
+		while (cursor < end && IsSpace(*cursor)) {
+			cursor++;
+		}
+		return cursor;
+	}
+
+	const char* NextLine(const char* cursor, const char* end) {
+		const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+		return newline == nullptr ? end : newline + 1;
+	}
+
+	// True when the line starts with keyword followed by whitespace; moves cursor past it
+	bool MatchKeyword(const char*& cursor, const char* end, const char* keyword) {
+		size_t length = std::strlen(keyword);
+		if (static_cast<size_t>(end - cursor) <= length || std::memcmp(cursor, keyword, length) != 0 || !IsSpace(cursor[length])) {
+			return false;
+		}
+		cursor += length;
+		return true;
+	}
+
+	// Remainder of the line with surrounding whitespace and '\r' stripped
+	std::string_view ParseRest(const char* cursor, const char* end) {
+		cursor = SkipSpaces(cursor, end);
+		const char* lineEnd = cursor;
+		while (lineEnd < end && *lineEnd != '\n' && *lineEnd != '\r') {
+			lineEnd++;
+		}
+		while (lineEnd > cursor && IsSpace(lineEnd[-1])) {
+			lineEnd--;
+		}
+		return std::string_view(cursor, static_cast<size_t>(lineEnd - cursor));
+	}
+
+	// Decimal float parser without locale or error handling overhead; accurate to a few ULP
+	float ParseFloat(const char*& cursor, const char* end) {
+		cursor = SkipSpaces(cursor, end);
+
+		bool negative = false;
+		if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+			negative = *cursor == '-';
+			cursor++;
+		}
+
+		uint64_t mantissa = 0;
+		int exponent = 0;
+		int digits = 0;
+		while (cursor < end && IsDigit(*cursor)) {
+			if (digits < 19) {
+				mantissa = mantissa * 10 + (*cursor - '0');
+				digits += mantissa != 0;
+			}
+			else {
+				exponent++;
+			}
+			cursor++;
+		}
+
+		if (cursor < end && *cursor == '.') {
+			cursor++;
+			while (cursor < end && IsDigit(*cursor)) {
+				if (digits < 19) {
+					mantissa = mantissa * 10 + (*cursor - '0');
+					digits += mantissa != 0;
+					exponent--;
+				}
+				cursor++;
+			}
+		}
+
+		if (cursor < end && (*cursor == 'e' || *cursor == 'E')) {
+			cursor++;
+			bool negativeExponent = false;
+			if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+				negativeExponent = *cursor == '-';
+				cursor++;
+			}
+			int explicitExponent = 0;
+			while (cursor < end && IsDigit(*cursor)) {
+				explicitExponent = std::min(explicitExponent * 10 + (*cursor - '0'), 1000);
+				cursor++;
+			}
+			exponent += negativeExponent ? -explicitExponent : explicitExponent;
+		}
+
+		double value = static_cast<double>(mantissa);
+		while (exponent > 20) {
+			value *= 1e20;
+			exponent -= 20;
+		}
+		while (exponent < -20) {
+			value /= 1e20;
+			exponent += 20;
+		}
+		value = exponent >= 0 ? value * POWERS_OF_TEN[exponent] : value / POWERS_OF_TEN[-exponent];
+
+		return static_cast<float>(negative ? -value : value);
+	}
+
+	int32_t ParseInt(const char*& cursor, const char* end) {
+		bool negative = false;
+		if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+			negative = *cursor == '-';
+			cursor++;
+		}
+
+		int32_t value = 0;
+		while (cursor < end && IsDigit(*cursor)) {
+			value = value * 10 + (*cursor - '0');
+			cursor++;
+		}
+		return negative ? -value : value;
+	}
+
+	// OBJ indices are one-based, or negative to count back from the latest element
+	int32_t ResolveIndex(int32_t index, uint32_t countSoFar) {
+		if (index > 0) {
+			return index - 1;
+		}
+		if (index < 0 && static_cast<int64_t>(countSoFar) + index >= 0) {
+			return static_cast<int32_t>(countSoFar) + index;
+		}
+		return INVALID_INDEX;
+	}
+
+	void CountChunk(ObjChunk& chunk) {
+		const char* cursor = chunk.begin;
+		while (cursor < chunk.end) {
+			const char* lineEnd = NextLine(cursor, chunk.end);
+			const char* line = SkipSpaces(cursor, lineEnd);
+			if (line < lineEnd) {
+				if (line[0] == 'v' && line + 1 < lineEnd) {
+					if (IsSpace(line[1])) {
+						chunk.positionCount++;
+					}
+					else if (line[1] == 't' && line + 2 < lineEnd && IsSpace(line[2])) {
+						chunk.texCoordCount++;
+					}
+					else if (line[1] == 'n' && line + 2 < lineEnd && IsSpace(line[2])) {
+						chunk.normalCount++;
+					}
+				}
+				else if (MatchKeyword(line, lineEnd, "g") || MatchKeyword(line, lineEnd, "o")) {
+					chunk.setsGroup = true;
+					chunk.lastGroup = ParseRest(line, lineEnd);
+				}
+				else if (MatchKeyword(line, lineEnd, "usemtl")) {
+					chunk.setsMaterial = true;
+					chunk.lastMaterial = ParseRest(line, lineEnd);
+				}
+				else if (MatchKeyword(line, lineEnd, "mtllib")) {
+					chunk.materialLibraries.emplace_back(ParseRest(line, lineEnd));
+				}
+			}
+			cursor = lineEnd;
+		}
+	}
+
+	void ParseChunk(ObjChunk& chunk, std::vector<glm::vec3>& positions, std::vector<glm::vec2>& texCoords, std::vector<glm::vec3>& normals) {
+		uint32_t positionCount = chunk.positionBase;
+		uint32_t texCoordCount = chunk.texCoordBase;
+		uint32_t normalCount = chunk.normalBase;
+
+		chunk.runs.push_back(FaceRun{ chunk.startGroup, chunk.startMaterial, {} });
+		std::vector<ObjIndex> polygon;
+
+		const char* cursor = chunk.begin;
+		while (cursor < chunk.end) {
+			const char* lineEnd = NextLine(cursor, chunk.end);
+			const char* line = SkipSpaces(cursor, lineEnd);
+			if (line >= lineEnd) {
+				cursor = lineEnd;
+				continue;
+			}
+
+			// Dispatch on the first character; most lines are v, vt, vn or f
+			switch (line[0]) {
+			case 'v':
+				if (MatchKeyword(line, lineEnd, "v")) {
+					glm::vec3& position = positions[positionCount++];
+					position.x = ParseFloat(line, lineEnd);
+					position.y = ParseFloat(line, lineEnd);
+					position.z = ParseFloat(line, lineEnd);
+				}
+				else if (MatchKeyword(line, lineEnd, "vt")) {
+					glm::vec2& texCoord = texCoords[texCoordCount++];
+					texCoord.x = ParseFloat(line, lineEnd);
+					texCoord.y = 1.f - ParseFloat(line, lineEnd);
+				}
+				else if (MatchKeyword(line, lineEnd, "vn")) {
+					glm::vec3& normal = normals[normalCount++];
+					normal.x = ParseFloat(line, lineEnd);
+					normal.y = ParseFloat(line, lineEnd);
+					normal.z = ParseFloat(line, lineEnd);
+				}
+				break;
+			case 'f':
+				if (MatchKeyword(line, lineEnd, "f")) {
+					polygon.clear();
+					while (true) {
+						line = SkipSpaces(line, lineEnd);
+						if (line >= lineEnd || !(IsDigit(*line) || *line == '-' || *line == '+')) {
+							break;
+						}
+
+						ObjIndex index = { ResolveIndex(ParseInt(line, lineEnd), positionCount), NO_INDEX, NO_INDEX };
+						if (line < lineEnd && *line == '/') {
+							line++;
+							if (line < lineEnd && *line != '/') {
+								index.texCoord = ResolveIndex(ParseInt(line, lineEnd), texCoordCount);
+							}
+							if (line < lineEnd && *line == '/') {
+								line++;
+								index.normal = ResolveIndex(ParseInt(line, lineEnd), normalCount);
+							}
+						}
+						polygon.push_back(index);
+					}
+
+					// Fan triangulation, matching aiProcess_Triangulate for convex faces
+					std::vector<ObjIndex>& corners = chunk.runs.back().corners;
+					for (size_t i = 2; i < polygon.size(); i++) {
+						corners.push_back(polygon[0]);
+						corners.push_back(polygon[i - 1]);
+						corners.push_back(polygon[i]);
+					}
+				}
+				break;
+			case 'g':
+			case 'o':
+				if (MatchKeyword(line, lineEnd, "g") || MatchKeyword(line, lineEnd, "o")) {
+					std::string_view group = ParseRest(line, lineEnd);
+					// Repeated names are common in exporter output; only a change starts a new run
+					if (group != chunk.runs.back().group) {
+						if (chunk.runs.back().corners.empty()) {
+							chunk.runs.back().group = group;
+						}
+						else {
+							chunk.runs.push_back(FaceRun{ std::string(group), chunk.runs.back().material, {} });
+						}
+					}
+				}
+				break;
+			case 'u':
+				if (MatchKeyword(line, lineEnd, "usemtl")) {
+					std::string_view material = ParseRest(line, lineEnd);
+					if (material != chunk.runs.back().material) {
+						if (chunk.runs.back().corners.empty()) {
+							chunk.runs.back().material = material;
+						}
+						else {
+							chunk.runs.push_back(FaceRun{ chunk.runs.back().group, std::string(material), {} });
+						}
+					}
+				}
+				break;
+			}
+
+			cursor = lineEnd;
+		}
+	}
+
+	bool BuildMesh(const std::vector<ObjIndex>& corners, const std::vector<glm::vec3>& positions, const std::vector<glm::vec2>& texCoords,
+		const std::vector<glm::vec3>& normals, MeshData& mesh) {
+		VertexLookup uniqueVertices(corners.size());
+		mesh.indices.reserve(corners.size());
+
+		// Corners without a normal get a generated one; those with one keep the file's
+		std::vector<char> needsNormal;
+		bool generateNormals = false;
+		for (const ObjIndex& corner : corners) {
+			if (corner.position < 0 || corner.position >= static_cast<int32_t>(positions.size()) ||
+				corner.texCoord < NO_INDEX || corner.texCoord >= static_cast<int32_t>(texCoords.size()) ||
+				corner.normal < NO_INDEX || corner.normal >= static_cast<int32_t>(normals.size())) {
+				return false;
+			}
+
+			bool inserted;
+			uint32_t vertexIndex = uniqueVertices.FindOrInsert(corner, static_cast<uint32_t>(mesh.vertices.size()), inserted);
+			if (inserted) {
+				Vertex vertex;
+				vertex.Position = positions[corner.position];
+				vertex.Normal = corner.normal >= 0 ? normals[corner.normal] : glm::vec3(0.f);
+				vertex.TexCoords = corner.texCoord >= 0 ? texCoords[corner.texCoord] : glm::vec2(0.f);
+				mesh.vertices.push_back(vertex);
+				needsNormal.push_back(corner.normal < 0);
+				generateNormals |= corner.normal < 0;
+			}
+			mesh.indices.push_back(vertexIndex);
+		}
+
+		// Vertices without normals get area-weighted smooth normals over shared vertices
+		if (generateNormals) {
+			for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+				const uint32_t* triangle = &mesh.indices[i];
+				glm::vec3 faceNormal = glm::cross(mesh.vertices[triangle[1]].Position - mesh.vertices[triangle[0]].Position,
+					mesh.vertices[triangle[2]].Position - mesh.vertices[triangle[0]].Position);
+				for (size_t corner = 0; corner < 3; corner++) {
+					if (needsNormal[triangle[corner]]) {
+						mesh.vertices[triangle[corner]].Normal += faceNormal;
+					}
+				}
+			}
+			for (size_t i = 0; i < mesh.vertices.size(); i++) {
+				if (needsNormal[i]) {
+					float length = glm::length(mesh.vertices[i].Normal);
+					mesh.vertices[i].Normal = length > 0.f ? mesh.vertices[i].Normal / length : glm::vec3(0.f, 1.f, 0.f);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	std::string GetDirectory(const std::string& path) {
+		size_t separator = path.find_last_of("/\\");
+		return separator == std::string::npos ? std::string() : path.substr(0, separator + 1);
+	}
+
+	struct MapOption {
+		const char* name;
+		int minArguments;
+		int maxArguments;
+	};
+
+	// Options a map_* statement may put before its file name, with how many arguments follow each
+	const MapOption MAP_OPTIONS[] = {
+		{ "-blendu", 1, 1 }, { "-blendv", 1, 1 }, { "-boost", 1, 1 }, { "-bm", 1, 1 }, { "-cc", 1, 1 },
+		{ "-clamp", 1, 1 }, { "-imfchan", 1, 1 }, { "-mm", 2, 2 }, { "-texres", 1, 1 },
+		{ "-o", 1, 3 }, { "-s", 1, 3 }, { "-t", 1, 3 }
+	};
+
+	const char* TokenEnd(const char* cursor, const char* end) {
+		while (cursor < end && !IsSpace(*cursor)) {
+			cursor++;
+		}
+		return cursor;
+	}
+
+	bool IsNumber(const char* begin, const char* end) {
+		if (begin == end) {
+			return false;
+		}
+		for (const char* c = begin; c < end; c++) {
+			if (!IsDigit(*c) && *c != '-' && *c != '+' && *c != '.' && *c != 'e' && *c != 'E') {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// File name of a map_* statement: the rest of the line after any known options such as "-bm 1.0",
+	// so names with spaces are kept like mtllib and usemtl keep them
+	std::string ParseMapName(std::string_view arguments) {
+		const char* cursor = arguments.data();
+		const char* end = cursor + arguments.size();
+		while (true) {
+			cursor = SkipSpaces(cursor, end);
+			const char* tokenEnd = TokenEnd(cursor, end);
+			std::string_view token(cursor, static_cast<size_t>(tokenEnd - cursor));
+
+			const MapOption* option = nullptr;
+			for (const MapOption& candidate : MAP_OPTIONS) {
+				if (token == candidate.name) {
+					option = &candidate;
+					break;
+				}
+			}
+			if (option == nullptr) {
+				break;
+			}
+
+			cursor = tokenEnd;
+			for (int i = 0; i < option->maxArguments; i++) {
+				const char* argument = SkipSpaces(cursor, end);
+				const char* argumentEnd = TokenEnd(argument, end);
+				// Optional arguments are always numbers; anything else starts the file name
+				if (i >= option->minArguments && !IsNumber(argument, argumentEnd)) {
+					break;
+				}
+				cursor = argumentEnd;
+			}
+		}
+		return std::string(cursor, end);
+	}
+}
+
+bool ObjLoader::LoadMaterials(const std::string& path, std::vector<ObjMaterial>& materials) {
+	std::ifstream file(path);
+	if (!file.good()) {
+		std::cout << "ERROR: Could not open material library " << path << "\n";
+		return false;
+	}
+
+	std::string line;
+	while (std::getline(file, line)) {
+		const char* cursor = line.data();
+		const char* end = cursor + line.size();
+		cursor = SkipSpaces(cursor, end);
+
+		if (MatchKeyword(cursor, end, "newmtl")) {
+			materials.push_back(ObjMaterial());
+			materials.back().name = std::string(ParseRest(cursor, end));
+		}
+		else if (materials.empty()) {
+			continue;
+		}
+		else if (MatchKeyword(cursor, end, "map_Kd")) {
+			materials.back().diffuseMap = ParseMapName(ParseRest(cursor, end));
+		}
+		else if (MatchKeyword(cursor, end, "map_Bump") || MatchKeyword(cursor, end, "map_bump") || MatchKeyword(cursor, end, "bump")) {
+			materials.back().normalMap = ParseMapName(ParseRest(cursor, end));
+		}
+		else if (MatchKeyword(cursor, end, "map_Ks")) {
+			materials.back().specularMap = ParseMapName(ParseRest(cursor, end));
+		}
+	}
+
+	return true;
+}
+
+bool ObjLoader::Load(const std::string& path, std::vector<MeshData>& meshes, std::vector<std::string>* materialLibraries) {
+	auto start = std::chrono::steady_clock::now();
+
+	MappedFile file;
+	if (!file.Open(path)) {
+		std::cout << "ERROR: Could not open OBJ file " << path << "\n";
+		return false;
+	}
+
+	const char* data = reinterpret_cast<const char*>(file.GetData());
+	const char* dataEnd = data + file.GetSize();
+
+	// Split into line-aligned chunks, a few per worker so uneven chunks still balance
+	ThreadPool& pool = ThreadPool::Shared();
+	size_t targetChunks = (pool.GetThreadCount() + 1) * 4;
+	size_t chunkSize = std::max(MIN_CHUNK_SIZE, file.GetSize() / targetChunks + 1);
+	std::vector<ObjChunk> chunks;
+	const char* chunkBegin = data;
+	while (chunkBegin < dataEnd) {
+		const char* chunkEnd = chunkBegin + std::min(chunkSize, static_cast<size_t>(dataEnd - chunkBegin));
+		chunkEnd = chunkEnd < dataEnd ? NextLine(chunkEnd, dataEnd) : dataEnd;
+		ObjChunk chunk;
+		chunk.begin = chunkBegin;
+		chunk.end = chunkEnd;
+		chunks.push_back(std::move(chunk));
+		chunkBegin = chunkEnd;
+	}
+
+	// First pass counts elements so every chunk knows where its vertices land
+	pool.ParallelFor(chunks.size(), [&](size_t i) {
+		CountChunk(chunks[i]);
+	});
+
+	uint32_t positionCount = 0;
+	uint32_t texCoordCount = 0;
+	uint32_t normalCount = 0;
+	std::string_view group;
+	std::string_view material;
+	std::vector<std::string> libraryNames;
+	for (ObjChunk& chunk : chunks) {
+		chunk.positionBase = positionCount;
+		chunk.texCoordBase = texCoordCount;
+		chunk.normalBase = normalCount;
+		chunk.startGroup = std::string(group);
+		chunk.startMaterial = std::string(material);
+
+		positionCount += chunk.positionCount;
+		texCoordCount += chunk.texCoordCount;
+		normalCount += chunk.normalCount;
+		if (chunk.setsGroup) {
+			group = chunk.lastGroup;
+		}
+		if (chunk.setsMaterial) {
+			material = chunk.lastMaterial;
+		}
+		libraryNames.insert(libraryNames.end(), chunk.materialLibraries.begin(), chunk.materialLibraries.end());
+	}
+
+	std::vector<glm::vec3> positions(positionCount);
+	std::vector<glm::vec2> texCoords(texCoordCount);
+	std::vector<glm::vec3> normals(normalCount);
+	pool.ParallelFor(chunks.size(), [&](size_t i) {
+		ParseChunk(chunks[i], positions, texCoords, normals);
+	});
+
+	// Gather runs into one mesh per group/material pair, in order of first appearance
+	std::vector<FaceRun> meshRuns;
+	std::unordered_map<std::string, size_t> meshLookup;
+	for (ObjChunk& chunk : chunks) {
+		for (FaceRun& run : chunk.runs) {
+			if (run.corners.empty()) {
+				continue;
+			}
+			std::string key = run.group + '\n' + run.material;
+			auto inserted = meshLookup.emplace(key, meshRuns.size());
+			if (inserted.second) {
+				meshRuns.push_back(std::move(run));
+			}
+			else {
+				std::vector<ObjIndex>& corners = meshRuns[inserted.first->second].corners;
+				corners.insert(corners.end(), run.corners.begin(), run.corners.end());
+			}
+		}
+	}
+
+	std::vector<ObjMaterial> materials;
+	std::string directory = GetDirectory(path);
+	for (const std::string& library : libraryNames) {
+		LoadMaterials(directory + library, materials);
+		if (materialLibraries != nullptr) {
+			materialLibraries->push_back(directory + library);
+		}
+	}
+
+	size_t firstMesh = meshes.size();
+	meshes.resize(firstMesh + meshRuns.size());
+	std::vector<char> meshValid(meshRuns.size(), 0);
+	pool.ParallelFor(meshRuns.size(), [&](size_t i) {
+		meshValid[i] = BuildMesh(meshRuns[i].corners, positions, texCoords, normals, meshes[firstMesh + i]);
+	});
+
+	for (size_t i = 0; i < meshRuns.size(); i++) {
+		if (!meshValid[i]) {
+			std::cout << "ERROR: OBJ file " << path << " has out of range face indices\n";
+			meshes.resize(firstMesh);
+			return false;
+		}
+
+		for (const ObjMaterial& objMaterial : materials) {
+			if (objMaterial.name == meshRuns[i].material && !objMaterial.diffuseMap.empty()) {
+				meshes[firstMesh + i].diffuseTextures.push_back(objMaterial.diffuseMap);
+				break;
+			}
+		}
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	double megabytes = file.GetSize() / (1024.0 * 1024.0);
+	std::cout << "OBJ: parsed " << megabytes << " MB into " << meshRuns.size() << " meshes in " << elapsed.count() << " ms ("
+		<< megabytes / (elapsed.count() / 1000.0) << " MB/s)\n";
+
+	return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <vector>
+#include <string>
+
+struct ObjMaterial {
+	std::string name;
+	std::string diffuseMap;
+	std::string normalMap;
+	std::string specularMap;
+};
+
+// Native Wavefront OBJ/MTL reader that bypasses Assimp for the common case.
+// The file is mapped, split into line-aligned chunks and parsed on the worker pool.
+// Output matches the Assimp path: triangulated fans, flipped V coordinates, generated
+// normals when the file has none, and one mesh per group/material pair in file order.
+namespace ObjLoader {
+	// materialLibraries, if given, receives the paths of the MTL files the OBJ references, even if parsing fails later
+	bool Load(const std::string& path, std::vector<MeshData>& meshes, std::vector<std::string>* materialLibraries = nullptr);
+
+	bool LoadMaterials(const std::string& path, std::vector<ObjMaterial>& materials);
+}
@@ -0,0 +1,43 @@
+#include "ProcessMemory.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fstream>
+#include <string>
+#endif
+
+#ifdef _WIN32
+
+ProcessMemory ProcessMemory::Query() {
+	ProcessMemory memory;
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		memory.residentBytes = counters.WorkingSetSize;
+		memory.peakResidentBytes = counters.PeakWorkingSetSize;
+	}
+	return memory;
+}
+
+#else
+
+ProcessMemory ProcessMemory::Query() {
+	ProcessMemory memory;
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line)) {
+		// Values are reported in kB
+		if (line.compare(0, 6, "VmRSS:") == 0) {
+			memory.residentBytes = std::stoull(line.substr(6)) * 1024;
+		}
+		else if (line.compare(0, 6, "VmHWM:") == 0) {
+			memory.peakResidentBytes = std::stoull(line.substr(6)) * 1024;
+		}
+	}
+	return memory;
+}
+
+#endif
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+// Resident set of the whole process, in bytes; zero where the platform query fails
+struct ProcessMemory {
+	size_t residentBytes = 0;
+	// Highest resident set since the process started
+	size_t peakResidentBytes = 0;
+
+	static ProcessMemory Query();
+};
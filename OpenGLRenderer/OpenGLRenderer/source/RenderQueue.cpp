@@ -0,0 +1,126 @@
+#include "RenderQueue.h"
+
+#include <chrono>
+#include <cstring>
+#include <utility>
+#include <iostream>
+
+namespace {
+	constexpr uint32_t DEPTH_BITS = 16;
+	constexpr uint64_t PROGRAM_MASK = (1ull << RenderKey::PROGRAM_BITS) - 1;
+	constexpr uint64_t MATERIAL_MASK = (1ull << RenderKey::MATERIAL_BITS) - 1;
+	constexpr uint64_t DEPTH_MASK = (1ull << DEPTH_BITS) - 1;
+
+	constexpr uint32_t OPAQUE_PROGRAM_SHIFT = 52;
+	constexpr uint32_t OPAQUE_MATERIAL_SHIFT = 36;
+	constexpr uint32_t OPAQUE_DEPTH_SHIFT = 20;
+
+	constexpr uint32_t TRANSPARENT_DEPTH_SHIFT = 44;
+	constexpr uint32_t TRANSPARENT_PROGRAM_SHIFT = 36;
+	constexpr uint32_t TRANSPARENT_MATERIAL_SHIFT = 20;
+
+	// Four 11-bit digits cover the 44 key bits; the payload below them is already unique and needs no pass
+	constexpr uint32_t DIGIT_BITS = 11;
+	constexpr uint32_t DIGIT_COUNT = 4;
+	constexpr uint32_t DIGIT_VALUES = 1u << DIGIT_BITS;
+	constexpr uint64_t DIGIT_MASK = DIGIT_VALUES - 1;
+}
+
+uint64_t RenderKey::Make(uint32_t pass, bool transparent, uint32_t program, uint32_t material, float viewDepth) {
+	uint64_t key = static_cast<uint64_t>(pass & 0x7) << 61;
+	uint64_t depth = QuantizeDepth(viewDepth);
+	if (transparent) {
+		key |= 1ull << 60;
+		key |= (DEPTH_MASK - depth) << TRANSPARENT_DEPTH_SHIFT;
+		key |= (program & PROGRAM_MASK) << TRANSPARENT_PROGRAM_SHIFT;
+		key |= (material & MATERIAL_MASK) << TRANSPARENT_MATERIAL_SHIFT;
+	}
+	else {
+		key |= (program & PROGRAM_MASK) << OPAQUE_PROGRAM_SHIFT;
+		key |= (material & MATERIAL_MASK) << OPAQUE_MATERIAL_SHIFT;
+		key |= depth << OPAQUE_DEPTH_SHIFT;
+	}
+	return key;
+}
+
+uint32_t RenderKey::QuantizeDepth(float viewDepth) {
+	// Positive floats order the same as their bit patterns; this also maps NaN and negatives to 0
+	if (!(viewDepth > 0.f)) {
+		return 0;
+	}
+	uint32_t bits;
+	std::memcpy(&bits, &viewDepth, sizeof(bits));
+	return bits >> (32 - DEPTH_BITS);
+}
+
+uint32_t RenderKey::GetProgram(uint64_t key) {
+	uint32_t shift = IsTransparent(key) ? TRANSPARENT_PROGRAM_SHIFT : OPAQUE_PROGRAM_SHIFT;
+	return static_cast<uint32_t>((key >> shift) & PROGRAM_MASK);
+}
+
+uint32_t RenderKey::GetMaterial(uint64_t key) {
+	uint32_t shift = IsTransparent(key) ? TRANSPARENT_MATERIAL_SHIFT : OPAQUE_MATERIAL_SHIFT;
+	return static_cast<uint32_t>((key >> shift) & MATERIAL_MASK);
+}
+
+bool RenderQueue::Push(uint64_t key, uint32_t payload) {
+	if (payload > MAX_PAYLOAD) {
+		std::cout << "ERROR: Render queue payload " << payload << " does not fit in " << RenderKey::PAYLOAD_BITS << " bits\n";
+		return false;
+	}
+	entries.push_back((key & ~static_cast<uint64_t>(MAX_PAYLOAD)) | payload);
+	return true;
+}
+
+void RenderQueue::Sort() {
+	auto start = std::chrono::steady_clock::now();
+	stats.entries = entries.size();
+	stats.radixPasses = 0;
+
+	size_t count = entries.size();
+	if (count > 1) {
+		// One read builds the histograms of every digit
+		histograms.assign(DIGIT_COUNT * DIGIT_VALUES, 0);
+		uint32_t* counts = histograms.data();
+		for (uint64_t entry : entries) {
+			uint64_t key = entry >> RenderKey::PAYLOAD_BITS;
+			counts[key & DIGIT_MASK]++;
+			counts[DIGIT_VALUES + ((key >> DIGIT_BITS) & DIGIT_MASK)]++;
+			counts[2 * DIGIT_VALUES + ((key >> (2 * DIGIT_BITS)) & DIGIT_MASK)]++;
+			counts[3 * DIGIT_VALUES + (key >> (3 * DIGIT_BITS))]++;
+		}
+
+		scratch.resize(count);
+		uint64_t* source = entries.data();
+		uint64_t* destination = scratch.data();
+		for (uint32_t digit = 0; digit < DIGIT_COUNT; digit++) {
+			uint32_t* histogram = counts + digit * DIGIT_VALUES;
+			uint32_t shift = RenderKey::PAYLOAD_BITS + digit * DIGIT_BITS;
+			// Every key has the same digit here, so this pass would not move anything
+			if (histogram[(source[0] >> shift) & DIGIT_MASK] == count) {
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for (uint32_t value = 0; value < DIGIT_VALUES; value++) {
+				uint32_t valueCount = histogram[value];
+				histogram[value] = offset;
+				offset += valueCount;
+			}
+
+			for (size_t i = 0; i < count; i++) {
+				uint64_t entry = source[i];
+				destination[histogram[(entry >> shift) & DIGIT_MASK]++] = entry;
+			}
+			std::swap(source, destination);
+			stats.radixPasses++;
+		}
+
+		if (source != entries.data()) {
+			entries.swap(scratch);
+		}
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	stats.sortMilliseconds = elapsed.count();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Packs what decides draw order into the top 44 bits of an integer, most significant first:
+//   opaque:      pass(3) | 0 | program(8) | material(16) | depth(16)
+//   transparent: pass(3) | 1 | far-to-near depth(16) | program(8) | material(16)
+// so opaque draws group by state and go front to back within it, and transparent draws go back to front.
+// The low PAYLOAD_BITS are left for RenderQueue to store the payload in.
+struct RenderKey {
+	static constexpr uint32_t PAYLOAD_BITS = 20;
+	static constexpr uint32_t PROGRAM_BITS = 8;
+	static constexpr uint32_t MATERIAL_BITS = 16;
+
+	// viewDepth is the distance along the view direction; values behind the camera count as 0
+	static uint64_t Make(uint32_t pass, bool transparent, uint32_t program, uint32_t material, float viewDepth);
+
+	// Monotonic 16-bit bucket: the top bits of the float, so precision is relative to the distance
+	static uint32_t QuantizeDepth(float viewDepth);
+
+	static uint32_t GetPass(uint64_t key) { return static_cast<uint32_t>(key >> 61); }
+
+	static bool IsTransparent(uint64_t key) { return ((key >> 60) & 1) != 0; }
+
+	static uint32_t GetProgram(uint64_t key);
+
+	static uint32_t GetMaterial(uint64_t key);
+};
+
+struct RenderQueueStats {
+	size_t entries = 0;
+	// Digit passes that actually moved entries; digits equal across all keys are skipped
+	uint32_t radixPasses = 0;
+	double sortMilliseconds = 0.0;
+};
+
+// Draws recorded as sort keys with the payload packed into their low bits, put in key order by an
+// LSD radix sort over 11-bit digits. Packing keeps each entry at 8 bytes and makes every entry unique,
+// so equal keys come out in payload order. Reused every frame so its buffers stop allocating once grown.
+class RenderQueue {
+public:
+	static constexpr uint32_t MAX_PAYLOAD = (1u << RenderKey::PAYLOAD_BITS) - 1;
+
+	void Clear() { entries.clear(); }
+
+	void Reserve(size_t count) { entries.reserve(count); }
+
+	// payload is the caller's index of what to draw, e.g. a command; returns false if it does not fit
+	bool Push(uint64_t key, uint32_t payload);
+
+	void Sort();
+
+	// Sorted after Sort; read with GetPayload and the RenderKey accessors
+	const std::vector<uint64_t>& GetEntries() const { return entries; }
+
+	static uint32_t GetPayload(uint64_t entry) { return static_cast<uint32_t>(entry) & MAX_PAYLOAD; }
+
+	size_t GetSize() const { return entries.size(); }
+
+	const RenderQueueStats& GetStats() const { return stats; }
+
+private:
+	std::vector<uint64_t> entries;
+	std::vector<uint64_t> scratch;
+	// Counts, then write offsets, of each digit
+	std::vector<uint32_t> histograms;
+	RenderQueueStats stats;
+};
@@ -0,0 +1,122 @@
+#include "RenderThread.h"
+#include "GLFW/glfw3.h"
+
+namespace {
+	double MillisecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+}
+
+RenderThread::~RenderThread() {
+	Stop();
+}
+
+void RenderThread::Start(GLFWwindow* newWindow, RenderFunction newRender) {
+	window = newWindow;
+	render = std::move(newRender);
+	stopping = false;
+
+	// A context can only be current on one thread at a time
+	glfwMakeContextCurrent(NULL);
+	renderThread = std::thread(&RenderThread::ThreadLoop, this);
+}
+
+void RenderThread::Stop() {
+	if (!IsRunning()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(frameMutex);
+		stopping = true;
+	}
+	frameChanged.notify_all();
+	renderThread.join();
+
+	glfwMakeContextCurrent(window);
+}
+
+FrameSnapshot& RenderThread::BeginFrame() {
+	std::unique_lock<std::mutex> lock(frameMutex);
+	auto waitStart = std::chrono::steady_clock::now();
+	frameChanged.wait(lock, [this] { return renderingIndex != writeIndex && pendingIndex != writeIndex; });
+	stats.mainWaitMilliseconds = MillisecondsBetween(waitStart, std::chrono::steady_clock::now());
+	return snapshots[writeIndex];
+}
+
+void RenderThread::Publish(bool waitForCompletion) {
+	std::unique_lock<std::mutex> lock(frameMutex);
+	// Only happens when the render thread has not even picked up the previous frame yet
+	auto waitStart = std::chrono::steady_clock::now();
+	frameChanged.wait(lock, [this] { return pendingIndex == NO_FRAME; });
+	auto published = std::chrono::steady_clock::now();
+	stats.mainWaitMilliseconds += MillisecondsBetween(waitStart, published);
+
+	pendingIndex = writeIndex;
+	publishTimes[writeIndex] = published;
+	writeIndex ^= 1;
+	uint64_t frameNumber = ++stats.framesPublished;
+	frameChanged.notify_all();
+
+	if (waitForCompletion) {
+		frameChanged.wait(lock, [this, frameNumber] { return stats.framesRendered >= frameNumber; });
+		stats.mainWaitMilliseconds += MillisecondsBetween(published, std::chrono::steady_clock::now());
+	}
+}
+
+void RenderThread::GetFeedback(FrameFeedback& out) {
+	std::lock_guard<std::mutex> lock(frameMutex);
+	out = feedback;
+}
+
+RenderThreadStats RenderThread::GetStats() {
+	std::lock_guard<std::mutex> lock(frameMutex);
+	return stats;
+}
+
+void RenderThread::ThreadLoop() {
+	glfwMakeContextCurrent(window);
+
+	// Filled without the lock, then copied out in one go
+	FrameFeedback frameFeedback;
+	while (true) {
+		int index = NO_FRAME;
+		{
+			std::unique_lock<std::mutex> lock(frameMutex);
+			auto waitStart = std::chrono::steady_clock::now();
+			frameChanged.wait(lock, [this] { return pendingIndex != NO_FRAME || stopping; });
+			if (pendingIndex == NO_FRAME) {
+				break;
+			}
+
+			auto pickedUp = std::chrono::steady_clock::now();
+			stats.renderWaitMilliseconds = MillisecondsBetween(waitStart, pickedUp);
+			stats.handOffMilliseconds = MillisecondsBetween(publishTimes[pendingIndex], pickedUp);
+			index = pendingIndex;
+			renderingIndex = index;
+			pendingIndex = NO_FRAME;
+		}
+		frameChanged.notify_all();
+
+		auto renderStart = std::chrono::steady_clock::now();
+		FrameSnapshot& frame = snapshots[index];
+		render(frame, frameFeedback);
+		glfwSwapBuffers(window);
+		auto swapped = std::chrono::steady_clock::now();
+
+		{
+			std::lock_guard<std::mutex> lock(frameMutex);
+			stats.renderMilliseconds = MillisecondsBetween(renderStart, swapped);
+			stats.latencyMilliseconds = MillisecondsBetween(frame.inputTime, swapped);
+			if (stats.latencyMilliseconds > stats.peakLatencyMilliseconds) {
+				stats.peakLatencyMilliseconds = stats.latencyMilliseconds;
+			}
+			stats.framesRendered++;
+			feedback = frameFeedback;
+			renderingIndex = NO_FRAME;
+		}
+		frameChanged.notify_all();
+	}
+
+	glfwMakeContextCurrent(NULL);
+}
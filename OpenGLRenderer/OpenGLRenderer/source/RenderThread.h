@@ -0,0 +1,79 @@
+#pragma once
+
+#include "FrameSnapshot.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+struct GLFWwindow;
+
+struct RenderThreadStats {
+	uint64_t framesPublished = 0;
+	uint64_t framesRendered = 0;
+	// Last frame: published to picked up by the render thread
+	double handOffMilliseconds = 0.0;
+	// Last frame: input sampled on the main thread to buffers swapped on the render thread
+	double latencyMilliseconds = 0.0;
+	double peakLatencyMilliseconds = 0.0;
+	// Last frame: drawing and swapping on the render thread
+	double renderMilliseconds = 0.0;
+	// Last frame: main thread blocked on a busy snapshot, and render thread idle waiting for one
+	double mainWaitMilliseconds = 0.0;
+	double renderWaitMilliseconds = 0.0;
+};
+
+// Owns the GL context on a dedicated thread that draws frame snapshots produced by the main thread.
+// Two snapshots alternate: while the render thread submits frame N, the main thread fills frame N+1,
+// and it only blocks when it would get more than one frame ahead.
+class RenderThread {
+public:
+	// Draws one frame on the render thread; buffers are swapped after it returns
+	using RenderFunction = std::function<void(FrameSnapshot& frame, FrameFeedback& feedback)>;
+
+	~RenderThread();
+
+	// Releases the window's context on the calling thread and makes it current on the render thread
+	void Start(GLFWwindow* window, RenderFunction render);
+
+	// Draws any published frame, stops the thread and makes the context current on the calling thread again
+	void Stop();
+
+	bool IsRunning() const { return renderThread.joinable(); }
+
+	// Blocks until the render thread no longer needs the next snapshot, then hands it to the main thread to fill
+	FrameSnapshot& BeginFrame();
+
+	// Queues the snapshot from BeginFrame; with waitForCompletion, returns only once it has been drawn,
+	// for frames whose snapshot points at state the main thread must not touch meanwhile
+	void Publish(bool waitForCompletion);
+
+	// Copies out the feedback of the last frame drawn
+	void GetFeedback(FrameFeedback& feedback);
+
+	RenderThreadStats GetStats();
+
+private:
+	static constexpr int NO_FRAME = -1;
+
+	GLFWwindow* window = nullptr;
+	RenderFunction render;
+	std::thread renderThread;
+
+	FrameSnapshot snapshots[2];
+	std::chrono::steady_clock::time_point publishTimes[2];
+	int writeIndex = 0;
+	// Published but not yet picked up, and being drawn
+	int pendingIndex = NO_FRAME;
+	int renderingIndex = NO_FRAME;
+	bool stopping = false;
+
+	FrameFeedback feedback;
+	RenderThreadStats stats;
+
+	std::mutex frameMutex;
+	std::condition_variable frameChanged;
+
+	void ThreadLoop();
+};
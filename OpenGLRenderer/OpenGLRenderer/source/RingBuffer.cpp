@@ -0,0 +1,107 @@
+#include "RingBuffer.h"
+#include "glad/glad.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+RingBuffer& RingBuffer::Instance() {
+	static RingBuffer ring;
+	return ring;
+}
+
+void RingBuffer::BeginFrame() {
+	if (mapped == nullptr) {
+		CreateStorage();
+		if (mapped == nullptr) {
+			return;
+		}
+	}
+
+	if (frameStarted) {
+		regionFences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		stats.lastFrameBytes = regionOffset;
+		stats.peakFrameBytes = std::max(stats.peakFrameBytes, regionOffset);
+		region = (region + 1) % REGION_COUNT;
+	}
+	frameStarted = true;
+	regionOffset = 0;
+	stats.lastWaitMilliseconds = 0.0;
+
+	GLsync fence = static_cast<GLsync>(regionFences[region]);
+	if (fence == nullptr) {
+		return;
+	}
+
+	// Usually signalled long ago; only block if the GPU is more than REGION_COUNT - 1 frames behind
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED) {
+		auto start = std::chrono::steady_clock::now();
+		do {
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		} while (result == GL_TIMEOUT_EXPIRED);
+		std::chrono::duration<double, std::milli> waited = std::chrono::steady_clock::now() - start;
+		stats.waits++;
+		stats.lastWaitMilliseconds = waited.count();
+		stats.totalWaitMilliseconds += waited.count();
+	}
+	if (result == GL_WAIT_FAILED) {
+		std::cout << "ERROR: Waiting on a ring buffer fence failed\n";
+	}
+	glDeleteSync(fence);
+	regionFences[region] = nullptr;
+}
+
+RingAllocation RingBuffer::Allocate(size_t size, size_t alignment) {
+	RingAllocation allocation;
+	size_t offset = (regionOffset + alignment - 1) / alignment * alignment;
+	if (mapped == nullptr || offset + size > regionBytes) {
+		stats.overflows++;
+		return allocation;
+	}
+
+	regionOffset = offset + size;
+	allocation.offset = static_cast<size_t>(region) * regionBytes + offset;
+	allocation.data = mapped + allocation.offset;
+	allocation.buffer = buffer.GetName();
+	return allocation;
+}
+
+void RingBuffer::Shutdown() {
+	for (void*& fence : regionFences) {
+		if (fence != nullptr) {
+			glDeleteSync(static_cast<GLsync>(fence));
+			fence = nullptr;
+		}
+	}
+	if (mapped != nullptr) {
+		glUnmapNamedBuffer(buffer.GetName());
+		mapped = nullptr;
+	}
+	buffer.Reset();
+	frameStarted = false;
+}
+
+void RingBuffer::CreateStorage() {
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	uniformAlignment = std::max<size_t>(alignment, 16);
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	storageAlignment = std::max<size_t>(alignment, 16);
+	// Every region starts on a boundary any binding accepts
+	size_t regionAlignment = std::max(uniformAlignment, storageAlignment);
+	regionBytes = (regionBytes + regionAlignment - 1) / regionAlignment * regionAlignment;
+
+	uint32_t name;
+	glCreateBuffers(1, &name);
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glNamedBufferStorage(name, static_cast<GLsizeiptr>(regionBytes * REGION_COUNT), nullptr, flags);
+	buffer = GpuResource(GpuResourceType::Buffer, name, regionBytes * REGION_COUNT);
+
+	mapped = static_cast<uint8_t*>(glMapNamedBufferRange(name, 0, static_cast<GLsizeiptr>(regionBytes * REGION_COUNT), flags));
+	if (mapped == nullptr) {
+		std::cout << "ERROR: Could not map the ring buffer\n";
+		buffer.Reset();
+	}
+	stats.regionBytes = regionBytes;
+}
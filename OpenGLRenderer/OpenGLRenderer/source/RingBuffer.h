@@ -0,0 +1,67 @@
+#pragma once
+
+#include "GpuResources.h"
+
+#include <cstdint>
+#include <cstddef>
+
+struct RingAllocation {
+	// Null when the region is full
+	void* data = nullptr;
+	uint32_t buffer = 0;
+	size_t offset = 0;
+};
+
+struct RingBufferStats {
+	size_t regionBytes = 0;
+	size_t lastFrameBytes = 0;
+	size_t peakFrameBytes = 0;
+	// Frames where the CPU got ahead of the GPU and had to block on a region's fence
+	uint64_t waits = 0;
+	double lastWaitMilliseconds = 0.0;
+	double totalWaitMilliseconds = 0.0;
+	uint64_t overflows = 0;
+};
+
+// One persistently mapped, coherent buffer split into REGION_COUNT regions, one per frame in flight.
+// Each frame writes only its own region; a fence on every region keeps the CPU from overwriting
+// data the GPU has not consumed yet. GL thread only.
+class RingBuffer {
+public:
+	static constexpr uint32_t REGION_COUNT = 3;
+	static constexpr size_t DEFAULT_REGION_BYTES = 8 << 20;
+
+	static RingBuffer& Instance();
+
+	// Called once per frame before anything is written: fences the previous region and moves to the next,
+	// waiting for the GPU only if it is still reading that region
+	void BeginFrame();
+
+	// Suballocates from this frame's region; the pointer may be written until the next BeginFrame
+	RingAllocation Allocate(size_t size, size_t alignment);
+
+	// Alignment glBindBufferRange requires for uniform blocks
+	size_t GetUniformAlignment() const { return uniformAlignment; }
+
+	size_t GetStorageAlignment() const { return storageAlignment; }
+
+	const RingBufferStats& GetStats() const { return stats; }
+
+	void Shutdown();
+
+private:
+	GpuResource buffer;
+	uint8_t* mapped = nullptr;
+	size_t regionBytes = DEFAULT_REGION_BYTES;
+	size_t uniformAlignment = 256;
+	size_t storageAlignment = 256;
+
+	uint32_t region = 0;
+	size_t regionOffset = 0;
+	void* regionFences[REGION_COUNT] = {};
+	bool frameStarted = false;
+
+	RingBufferStats stats;
+
+	void CreateStorage();
+};
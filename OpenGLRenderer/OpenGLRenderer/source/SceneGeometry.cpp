@@ -0,0 +1,339 @@
+#include "SceneGeometry.h"
+#include "VertexLayout.h"
+#include "RingBuffer.h"
+#include "GLState.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+	constexpr uint32_t INITIAL_POOL_VERTICES = 1 << 16;
+	constexpr uint32_t INITIAL_POOL_INDICES = 1 << 18;
+	// Compaction starts once free space is this splintered
+	constexpr float COMPACTION_FRAGMENTATION = 0.25f;
+	// Ranges tried per arena per frame, so a full arena cannot stall a frame
+	constexpr size_t MAX_COMPACTION_CANDIDATES = 64;
+}
+
+GeometryPool::GeometryPool(bool compactVertices, bool wideIndices)
+	: vertexArena(compactVertices ? sizeof(CompactVertex) : sizeof(Vertex), INITIAL_POOL_VERTICES),
+	indexArena(wideIndices ? sizeof(uint32_t) : sizeof(uint16_t), INITIAL_POOL_INDICES) {
+	this->compactVertices = compactVertices;
+	indexType = wideIndices ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+
+	uint32_t name;
+	glGenVertexArrays(1, &name);
+	vertexArray = GpuResource(GpuResourceType::VertexArray, name, 0);
+	UpdateBindings();
+}
+
+uint32_t GeometryPool::Allocate(const void* vertexData, uint32_t vertexCount, const void* indexData, uint32_t indexCount) {
+	GeometryRange range;
+	if (!AllocateRange(vertexCount, indexCount, range)) {
+		return INVALID_ALLOCATION;
+	}
+
+	vertexArena.Upload(range.baseVertex, vertexData, vertexCount);
+	indexArena.Upload(range.firstIndex, indexData, indexCount);
+	return AddAllocation(range);
+}
+
+uint32_t GeometryPool::AllocateFromBuffer(uint32_t sourceBuffer, size_t vertexByteOffset, uint32_t vertexCount, size_t indexByteOffset, uint32_t indexCount) {
+	GeometryRange range;
+	if (!AllocateRange(vertexCount, indexCount, range)) {
+		return INVALID_ALLOCATION;
+	}
+
+	vertexArena.CopyFrom(sourceBuffer, vertexByteOffset, range.baseVertex, vertexCount);
+	indexArena.CopyFrom(sourceBuffer, indexByteOffset, range.firstIndex, indexCount);
+	return AddAllocation(range);
+}
+
+bool GeometryPool::AllocateRange(uint32_t vertexCount, uint32_t indexCount, GeometryRange& range) {
+	range.vertexCount = vertexCount;
+	range.indexCount = indexCount;
+	range.baseVertex = vertexArena.Allocate(vertexCount);
+	range.firstIndex = indexArena.Allocate(indexCount);
+	UpdateBindings();
+
+	if (range.baseVertex != TlsfAllocator::INVALID_OFFSET && range.firstIndex != TlsfAllocator::INVALID_OFFSET) {
+		return true;
+	}
+
+	// Nothing was written to the half that succeeded, so it can go back straight away
+	if (range.baseVertex != TlsfAllocator::INVALID_OFFSET) {
+		vertexArena.FreeImmediately(range.baseVertex);
+	}
+	if (range.firstIndex != TlsfAllocator::INVALID_OFFSET) {
+		indexArena.FreeImmediately(range.firstIndex);
+	}
+	return false;
+}
+
+uint32_t GeometryPool::AddAllocation(const GeometryRange& range) {
+	uint32_t allocation;
+	if (!freeAllocations.empty()) {
+		allocation = freeAllocations.back();
+		freeAllocations.pop_back();
+		allocations[allocation] = range;
+		liveAllocations[allocation] = true;
+	}
+	else {
+		allocation = static_cast<uint32_t>(allocations.size());
+		allocations.push_back(range);
+		liveAllocations.push_back(true);
+	}
+	return allocation;
+}
+
+void GeometryPool::Free(uint32_t allocation, uint64_t frameSerial) {
+	if (allocation == INVALID_ALLOCATION) {
+		return;
+	}
+
+	const GeometryRange& range = allocations[allocation];
+	vertexArena.FreeDeferred(range.baseVertex, frameSerial);
+	indexArena.FreeDeferred(range.firstIndex, frameSerial);
+
+	// The id itself is only known to the CPU, so it can be reused straight away
+	liveAllocations[allocation] = false;
+	freeAllocations.push_back(allocation);
+}
+
+void GeometryPool::Retire(uint64_t completedSerial) {
+	vertexArena.Retire(completedSerial);
+	indexArena.Retire(completedSerial);
+}
+
+size_t GeometryPool::Compact(size_t budgetBytes, uint64_t frameSerial) {
+	size_t moved = CompactArena(vertexArena, &GeometryRange::baseVertex, &GeometryRange::vertexCount, budgetBytes, frameSerial);
+	if (moved < budgetBytes) {
+		moved += CompactArena(indexArena, &GeometryRange::firstIndex, &GeometryRange::indexCount, budgetBytes - moved, frameSerial);
+	}
+	return moved;
+}
+
+size_t GeometryPool::CompactArena(BufferArena& arena, uint32_t GeometryRange::* offset, uint32_t GeometryRange::* count, size_t budgetBytes,
+	uint64_t frameSerial) {
+	if (arena.GetStats().GetFragmentation() < COMPACTION_FRAGMENTATION) {
+		return 0;
+	}
+
+	// Highest ranges first, since moving them down is what consolidates free space
+	std::vector<uint32_t> candidates;
+	for (uint32_t i = 0; i < allocations.size(); i++) {
+		if (liveAllocations[i] && allocations[i].*count > 0) {
+			candidates.push_back(i);
+		}
+	}
+	size_t candidateCount = std::min(candidates.size(), MAX_COMPACTION_CANDIDATES);
+	std::partial_sort(candidates.begin(), candidates.begin() + candidateCount, candidates.end(), [&](uint32_t a, uint32_t b) {
+		return allocations[a].*offset > allocations[b].*offset;
+	});
+
+	size_t moved = 0;
+	for (size_t i = 0; i < candidateCount && moved < budgetBytes; i++) {
+		GeometryRange& range = allocations[candidates[i]];
+		uint32_t destination = arena.Allocate(range.*count, false);
+		if (destination == TlsfAllocator::INVALID_OFFSET) {
+			continue;
+		}
+		if (destination > range.*offset) {
+			arena.FreeImmediately(destination);
+			continue;
+		}
+
+		// Draws already submitted still read the old range, so it is freed behind this frame's fence
+		arena.Copy(range.*offset, destination, range.*count);
+		arena.FreeDeferred(range.*offset, frameSerial);
+		range.*offset = destination;
+		moved += static_cast<size_t>(range.*count) * arena.GetElementSize();
+	}
+	return moved;
+}
+
+void GeometryPool::Bind() const {
+	GLStateCache::Instance().BindVertexArray(vertexArray.GetName());
+}
+
+void GeometryPool::RecordBind(CommandList& commandList) const {
+	commandList.BindVertexArray(vertexArray.GetName());
+}
+
+void GeometryPool::Destroy() {
+	vertexArray.Reset();
+	vertexArena.Destroy();
+	indexArena.Destroy();
+}
+
+void GeometryPool::UpdateBindings() {
+	if (boundVertexBuffer == vertexArena.GetBuffer() && boundIndexBuffer == indexArena.GetBuffer()) {
+		return;
+	}
+
+	// Attribute pointers capture the buffer, so they are set again for a new one
+	GLStateCache& state = GLStateCache::Instance();
+	state.BindVertexArray(vertexArray.GetName());
+	state.BindBuffer(GL_ARRAY_BUFFER, vertexArena.GetBuffer());
+	if (compactVertices) {
+		SetupVertexAttributes<Interleaved<CompactVertexLayout>>(0);
+	}
+	else {
+		SetupVertexAttributes<Interleaved<StandardVertexLayout>>(0);
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexArena.GetBuffer());
+
+	boundVertexBuffer = vertexArena.GetBuffer();
+	boundIndexBuffer = indexArena.GetBuffer();
+}
+
+SceneGeometry& SceneGeometry::Instance() {
+	static SceneGeometry instance;
+	return instance;
+}
+
+GeometryPool& SceneGeometry::GetPool(bool compactVertices, bool wideIndices) {
+	std::unique_ptr<GeometryPool>& pool = pools[(compactVertices ? 2 : 0) + (wideIndices ? 1 : 0)];
+	if (!pool) {
+		pool = std::make_unique<GeometryPool>(compactVertices, wideIndices);
+	}
+	return *pool;
+}
+
+uint32_t SceneGeometry::AddDrawData(const MeshDrawData& data) {
+	drawDataDirty = true;
+	if (!freeDrawIds.empty()) {
+		uint32_t drawId = freeDrawIds.back();
+		freeDrawIds.pop_back();
+		drawData[drawId] = data;
+		return drawId;
+	}
+
+	drawData.push_back(data);
+	return static_cast<uint32_t>(drawData.size() - 1);
+}
+
+void SceneGeometry::Release(GeometryPool& pool, uint32_t allocation, uint32_t drawId) {
+	uint64_t frameSerial = GpuResourceRegistry::Instance().GetFrameSerial();
+	pool.Free(allocation, frameSerial);
+	pendingDrawIds.push_back(PendingDrawId{ drawId, frameSerial });
+}
+
+void SceneGeometry::Update(size_t compactionBudgetBytes) {
+	uint64_t frameSerial = GpuResourceRegistry::Instance().GetFrameSerial();
+	uint64_t completedSerial = GpuResourceRegistry::Instance().GetCompletedSerial();
+
+	for (std::unique_ptr<GeometryPool>& pool : pools) {
+		if (pool) {
+			pool->Retire(completedSerial);
+		}
+	}
+
+	auto retired = std::remove_if(pendingDrawIds.begin(), pendingDrawIds.end(), [&](const PendingDrawId& pending) {
+		if (pending.frameSerial > completedSerial) {
+			return false;
+		}
+		freeDrawIds.push_back(pending.drawId);
+		return true;
+	});
+	pendingDrawIds.erase(retired, pendingDrawIds.end());
+
+	size_t moved = 0;
+	for (std::unique_ptr<GeometryPool>& pool : pools) {
+		if (pool && moved < compactionBudgetBytes) {
+			moved += pool->Compact(compactionBudgetBytes - moved, frameSerial);
+		}
+	}
+	compactedBytes += moved;
+}
+
+void SceneGeometry::BindDrawData() {
+	if (drawDataBuffer.GetName() == 0) {
+		uint32_t name;
+		glCreateBuffers(1, &name);
+		drawDataBuffer = GpuResource(GpuResourceType::Buffer, name, 0);
+	}
+	if (drawDataDirty) {
+		glNamedBufferData(drawDataBuffer.GetName(), drawData.size() * sizeof(MeshDrawData), drawData.data(), GL_STATIC_DRAW);
+		drawDataBuffer.SetBytes(drawData.size() * sizeof(MeshDrawData));
+		drawDataDirty = false;
+	}
+	GLStateCache::Instance().BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, drawDataBuffer.GetName());
+}
+
+void SceneGeometry::PrepareVertexPulling() {
+	if (pullingVertexArray.GetName() == 0) {
+		uint32_t name;
+		glCreateVertexArrays(1, &name);
+		pullingVertexArray = GpuResource(GpuResourceType::VertexArray, name, 0);
+	}
+}
+
+void SceneGeometry::RecordBindForVertexPulling(CommandList& commandList, const GeometryPool& pool) const {
+	uint32_t pullingVao = pullingVertexArray.GetName();
+	// Arena buffers are replaced when they grow, so the element buffer is set on every bind
+	commandList.SetVertexArrayElementBuffer(pullingVao, pool.GetIndexArena().GetBuffer());
+	commandList.BindVertexArray(pullingVao);
+	commandList.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, pool.GetVertexArena().GetBuffer());
+}
+
+size_t SceneGeometry::UploadDrawCommands(const std::vector<DrawElementsIndirectCommand>& commands) {
+	size_t bytes = commands.size() * sizeof(DrawElementsIndirectCommand);
+	RingAllocation allocation = RingBuffer::Instance().Allocate(bytes, sizeof(DrawElementsIndirectCommand));
+	if (allocation.data != nullptr) {
+		std::memcpy(allocation.data, commands.data(), bytes);
+		GLStateCache::Instance().BindBuffer(GL_DRAW_INDIRECT_BUFFER, allocation.buffer);
+		return allocation.offset;
+	}
+
+	if (indirectBuffer.GetName() == 0) {
+		uint32_t name;
+		glGenBuffers(1, &name);
+		indirectBuffer = GpuResource(GpuResourceType::Buffer, name, 0);
+	}
+	GLStateCache::Instance().BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer.GetName());
+	// Orphans last frame's commands rather than waiting for the GPU to finish with them
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, bytes, commands.data(), GL_STREAM_DRAW);
+	indirectBuffer.SetBytes(bytes);
+	return 0;
+}
+
+SceneGeometryStats SceneGeometry::GetStats() const {
+	SceneGeometryStats stats;
+	for (const std::unique_ptr<GeometryPool>& pool : pools) {
+		if (!pool) {
+			continue;
+		}
+
+		stats.pools++;
+		for (const BufferArena* arena : { &pool->GetVertexArena(), &pool->GetIndexArena() }) {
+			const TlsfStats& arenaStats = arena->GetStats();
+			stats.usedBytes += static_cast<size_t>(arenaStats.used) * arena->GetElementSize();
+			stats.capacityBytes += static_cast<size_t>(arenaStats.capacity) * arena->GetElementSize();
+			stats.peakUsedBytes += static_cast<size_t>(arenaStats.peakUsed) * arena->GetElementSize();
+			stats.liveAllocations += arenaStats.liveAllocations;
+			stats.totalAllocations += arenaStats.totalAllocations;
+			stats.totalFrees += arenaStats.totalFrees;
+			stats.growths += arena->GetGrowthCount();
+			stats.fragmentation = std::max(stats.fragmentation, arenaStats.GetFragmentation());
+		}
+	}
+	stats.drawDataCount = drawData.size() - freeDrawIds.size() - pendingDrawIds.size();
+	stats.compactedBytes = compactedBytes;
+	return stats;
+}
+
+void SceneGeometry::Shutdown() {
+	for (std::unique_ptr<GeometryPool>& pool : pools) {
+		if (pool) {
+			pool->Destroy();
+			pool.reset();
+		}
+	}
+	drawDataBuffer.Reset();
+	indirectBuffer.Reset();
+	pullingVertexArray.Reset();
+	drawData.clear();
+	freeDrawIds.clear();
+	pendingDrawIds.clear();
+}
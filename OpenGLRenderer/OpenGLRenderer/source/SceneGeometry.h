@@ -0,0 +1,174 @@
+#pragma once
+
+#include "VertexQuantization.h"
+#include "BufferArena.h"
+#include "CommandList.h"
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// Matches the layout glMultiDrawElementsIndirect reads
+struct DrawElementsIndirectCommand {
+	uint32_t count = 0;
+	uint32_t instanceCount = 1;
+	uint32_t firstIndex = 0;
+	int32_t baseVertex = 0;
+	// Index into the per-draw data buffer, read as gl_BaseInstance
+	uint32_t baseInstance = 0;
+};
+
+// Where a mesh lives inside a pool; indices are relative to baseVertex
+struct GeometryRange {
+	uint32_t baseVertex = 0;
+	uint32_t vertexCount = 0;
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+};
+
+// Per-draw constants in the std430 buffer at binding 0, see BasicTexture.vert
+struct MeshDrawData {
+	glm::vec4 positionOffset = glm::vec4(0.f);
+	glm::vec4 positionScale = glm::vec4(1.f);
+};
+
+// One VAO over a vertex arena and an index arena shared by every mesh of one vertex format and index width.
+// Meshes hold an allocation id rather than offsets, so compaction can move their ranges.
+class GeometryPool {
+public:
+	// Returned by Allocate when either arena has no room, e.g. for an empty mesh or past 4 GB; Free ignores it
+	static constexpr uint32_t INVALID_ALLOCATION = UINT32_MAX;
+
+	GeometryPool(bool compactVertices, bool wideIndices);
+
+	uint32_t Allocate(const void* vertexData, uint32_t vertexCount, const void* indexData, uint32_t indexCount);
+
+	// Same as Allocate, but the data is copied on the GPU from another buffer, e.g. one filled by the upload context
+	uint32_t AllocateFromBuffer(uint32_t sourceBuffer, size_t vertexByteOffset, uint32_t vertexCount, size_t indexByteOffset, uint32_t indexCount);
+
+	// The ranges stay readable until frameSerial completes
+	void Free(uint32_t allocation, uint64_t frameSerial);
+
+	void Retire(uint64_t completedSerial);
+
+	// Moves ranges from the top of each arena into lower holes, copying at most budgetBytes on the GPU
+	size_t Compact(size_t budgetBytes, uint64_t frameSerial);
+
+	const GeometryRange& GetRange(uint32_t allocation) const { return allocations[allocation]; }
+
+	void Bind() const;
+
+	// Same as Bind, for replay later; safe on any thread
+	void RecordBind(CommandList& commandList) const;
+
+	void Destroy();
+
+	bool HasCompactVertices() const { return compactVertices; }
+
+	uint32_t GetIndexType() const { return indexType; }
+
+	uint32_t GetIndexSize() const { return indexArena.GetElementSize(); }
+
+	uint32_t GetVertexSize() const { return vertexArena.GetElementSize(); }
+
+	const BufferArena& GetVertexArena() const { return vertexArena; }
+
+	const BufferArena& GetIndexArena() const { return indexArena; }
+
+private:
+	bool compactVertices;
+	uint32_t indexType;
+
+	GpuResource vertexArray;
+	uint32_t boundVertexBuffer = 0;
+	uint32_t boundIndexBuffer = 0;
+
+	BufferArena vertexArena;
+	BufferArena indexArena;
+
+	std::vector<GeometryRange> allocations;
+	std::vector<bool> liveAllocations;
+	std::vector<uint32_t> freeAllocations;
+
+	// Takes space in both arenas, or in neither
+	bool AllocateRange(uint32_t vertexCount, uint32_t indexCount, GeometryRange& range);
+
+	uint32_t AddAllocation(const GeometryRange& range);
+
+	// Re-points the VAO after an arena replaced its buffer
+	void UpdateBindings();
+
+	size_t CompactArena(BufferArena& arena, uint32_t GeometryRange::* offset, uint32_t GeometryRange::* count, size_t budgetBytes, uint64_t frameSerial);
+};
+
+struct SceneGeometryStats {
+	size_t pools = 0;
+	size_t usedBytes = 0;
+	size_t capacityBytes = 0;
+	size_t peakUsedBytes = 0;
+	size_t drawDataCount = 0;
+	uint32_t liveAllocations = 0;
+	uint64_t totalAllocations = 0;
+	uint64_t totalFrees = 0;
+	uint32_t growths = 0;
+	// Worst arena, see TlsfStats::GetFragmentation
+	float fragmentation = 0.f;
+	size_t compactedBytes = 0;
+};
+
+// Process-wide geometry pools plus the per-draw data every mesh indexes with its draw id.
+// Frees wait on the registry's frame fences so nothing the GPU may still read is reused. GL thread only.
+class SceneGeometry {
+public:
+	static SceneGeometry& Instance();
+
+	GeometryPool& GetPool(bool compactVertices, bool wideIndices);
+
+	// Returns the draw id to use as baseInstance for this mesh
+	uint32_t AddDrawData(const MeshDrawData& drawData);
+
+	// Gives a mesh's allocation and draw id back once the GPU is done with the current frame
+	void Release(GeometryPool& pool, uint32_t allocation, uint32_t drawId);
+
+	// Called once per frame after GpuResourceRegistry::Update: retires frees the GPU is done with and compacts a little
+	void Update(size_t compactionBudgetBytes);
+
+	// Uploads pending draw data and binds it at binding 0
+	void BindDrawData();
+
+	// Creates the one attribute-less vertex array vertex pulling draws with; GL thread, before recording
+	void PrepareVertexPulling();
+
+	// Records binding that vertex array with pool's index buffer, and pool's vertex buffer at binding 1
+	// for the shader to fetch from by gl_VertexID. Serves every pool and vertex format; safe on any thread.
+	void RecordBindForVertexPulling(CommandList& commandList, const GeometryPool& pool) const;
+
+	// Writes the commands into this frame's ring buffer region, falling back to an orphaned buffer if it is full.
+	// Leaves the buffer bound to GL_DRAW_INDIRECT_BUFFER and returns the byte offset of the first command.
+	size_t UploadDrawCommands(const std::vector<DrawElementsIndirectCommand>& commands);
+
+	SceneGeometryStats GetStats() const;
+
+	// Deletes all GL objects; called before the context goes away
+	void Shutdown();
+
+private:
+	struct PendingDrawId {
+		uint32_t drawId;
+		uint64_t frameSerial;
+	};
+
+	// Indexed by compactVertices * 2 + wideIndices
+	std::unique_ptr<GeometryPool> pools[4];
+
+	std::vector<MeshDrawData> drawData;
+	std::vector<uint32_t> freeDrawIds;
+	std::vector<PendingDrawId> pendingDrawIds;
+	bool drawDataDirty = false;
+	GpuResource drawDataBuffer;
+	GpuResource indirectBuffer;
+	GpuResource pullingVertexArray;
+
+	size_t compactedBytes = 0;
+};
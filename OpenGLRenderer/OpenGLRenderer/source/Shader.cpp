@@ -1,12 +1,60 @@
 #include "Shader.h"
 #include "glad/glad.h"
 #include "glm/gtc/type_ptr.hpp"
+#include "GLState.h"
 
 #include <fstream>
 #include <string>
 #include <sstream>
 #include <iostream>
 
+namespace {
+	template <typename T>
+	struct UniformType;
+
+	template <>
+	struct UniformType<bool> { static constexpr GLenum value = GL_BOOL; };
+
+	template <>
+	struct UniformType<int> { static constexpr GLenum value = GL_INT; };
+
+	template <>
+	struct UniformType<float> { static constexpr GLenum value = GL_FLOAT; };
+
+	template <>
+	struct UniformType<glm::vec3> { static constexpr GLenum value = GL_FLOAT_VEC3; };
+
+	template <>
+	struct UniformType<glm::mat4> { static constexpr GLenum value = GL_FLOAT_MAT4; };
+
+	bool IsSamplerType(GLenum type) {
+		switch (type) {
+		case GL_SAMPLER_1D:
+		case GL_SAMPLER_2D:
+		case GL_SAMPLER_3D:
+		case GL_SAMPLER_CUBE:
+		case GL_SAMPLER_2D_SHADOW:
+		case GL_SAMPLER_2D_ARRAY:
+		case GL_SAMPLER_2D_ARRAY_SHADOW:
+		case GL_SAMPLER_CUBE_SHADOW:
+		case GL_SAMPLER_2D_MULTISAMPLE:
+		case GL_SAMPLER_BUFFER:
+		case GL_INT_SAMPLER_2D:
+		case GL_UNSIGNED_INT_SAMPLER_2D:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	std::string GetResourceName(GLuint program, GLenum programInterface, GLint index, GLint nameLength) {
+		// The reported length counts the terminator
+		std::string name(nameLength > 0 ? nameLength - 1 : 0, '\0');
+		glGetProgramResourceName(program, programInterface, index, nameLength, NULL, &name[0]);
+		return name;
+	}
+}
+
 Shader::Shader(const char* vertexPath, const char* fragmentPath) {
 	std::string vertexCode;
 	std::ifstream vertexShaderFile;
@@ -56,30 +104,127 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
 
 	glDeleteShader(vertexShader);
 	glDeleteShader(fragmentShader);
+
+	Reflect();
 }
 
 void Shader::Use() {
-	glUseProgram(programId);
+	GLStateCache::Instance().UseProgram(programId);
+}
+
+void Shader::Set(UniformHandle<bool> uniform, bool value) const {
+	glProgramUniform1i(programId, uniform.location, (int)value);
+}
+
+void Shader::Set(UniformHandle<int> uniform, int value) const {
+	glProgramUniform1i(programId, uniform.location, value);
+}
+
+void Shader::Set(UniformHandle<float> uniform, float value) const {
+	glProgramUniform1f(programId, uniform.location, value);
 }
 
-void Shader::SetBool(const char* name, bool value) const {
-	glUniform1i(glGetUniformLocation(programId, name), (int)value);
+void Shader::Set(UniformHandle<glm::vec3> uniform, const glm::vec3& value) const {
+	glProgramUniform3fv(programId, uniform.location, 1, &value[0]);
 }
 
-void Shader::SetInt(const char* name, int value) const {
-	glUniform1i(glGetUniformLocation(programId, name), value);
+void Shader::Set(UniformHandle<glm::mat4> uniform, const glm::mat4& value) const {
+	glProgramUniformMatrix4fv(programId, uniform.location, 1, GL_FALSE, &value[0][0]);
 }
 
-void Shader::SetFloat(const char* name, float value) const {
-	glUniform1f(glGetUniformLocation(programId, name), value);
+template <typename T>
+UniformHandle<T> Shader::GetUniform(const char* name) const {
+	return UniformHandle<T>{ ResolveUniform(name, UniformType<T>::value) };
 }
 
-void Shader::SetVec3(const char* name, const glm::vec3& value) const {
-	glUniform3fv(glGetUniformLocation(programId, name), 1, &value[0]);
+template UniformHandle<bool> Shader::GetUniform<bool>(const char* name) const;
+template UniformHandle<int> Shader::GetUniform<int>(const char* name) const;
+template UniformHandle<float> Shader::GetUniform<float>(const char* name) const;
+template UniformHandle<glm::vec3> Shader::GetUniform<glm::vec3>(const char* name) const;
+template UniformHandle<glm::mat4> Shader::GetUniform<glm::mat4>(const char* name) const;
+
+const UniformInfo* Shader::FindUniform(const std::string& name) const {
+	auto found = uniforms.find(name);
+	return found != uniforms.end() ? &found->second : nullptr;
+}
+
+const ShaderBlockInfo* Shader::FindUniformBlock(const std::string& name) const {
+	auto found = uniformBlocks.find(name);
+	return found != uniformBlocks.end() ? &found->second : nullptr;
+}
+
+const ShaderBlockInfo* Shader::FindStorageBlock(const std::string& name) const {
+	auto found = storageBlocks.find(name);
+	return found != storageBlocks.end() ? &found->second : nullptr;
+}
+
+void Shader::Reflect() {
+	std::string name;
+	GLint count = 0;
+
+	glGetProgramInterfaceiv(programId, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+	const GLenum uniformProperties[] = { GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE, GL_BLOCK_INDEX };
+	for (GLint i = 0; i < count; i++) {
+		GLint values[5];
+		glGetProgramResourceiv(programId, GL_UNIFORM, i, 5, uniformProperties, 5, NULL, values);
+		// Block members have no location of their own; they are reached through their block
+		if (values[4] != -1) {
+			continue;
+		}
+
+		name = GetResourceName(programId, GL_UNIFORM, i, values[0]);
+		UniformInfo info;
+		info.type = static_cast<uint32_t>(values[1]);
+		info.location = values[2];
+		info.arraySize = values[3];
+		uniforms[name] = info;
+		// Arrays are reported as "name[0]", but are as often asked for by their bare name
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+			uniforms[name.substr(0, name.size() - 3)] = info;
+		}
+
+		if (IsSamplerType(info.type)) {
+			GLint unit = 0;
+			glGetUniformiv(programId, info.location, &unit);
+			samplers[name] = unit;
+		}
+	}
+
+	const GLenum blockProperties[] = { GL_NAME_LENGTH, GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+	const GLenum blockInterfaces[] = { GL_UNIFORM_BLOCK, GL_SHADER_STORAGE_BLOCK };
+	for (GLenum blockInterface : blockInterfaces) {
+		std::unordered_map<std::string, ShaderBlockInfo>& blocks = blockInterface == GL_UNIFORM_BLOCK ? uniformBlocks : storageBlocks;
+		glGetProgramInterfaceiv(programId, blockInterface, GL_ACTIVE_RESOURCES, &count);
+		for (GLint i = 0; i < count; i++) {
+			GLint values[3];
+			glGetProgramResourceiv(programId, blockInterface, i, 3, blockProperties, 3, NULL, values);
+			ShaderBlockInfo info;
+			info.index = static_cast<uint32_t>(i);
+			info.binding = values[1];
+			info.dataSize = values[2];
+			blocks[GetResourceName(programId, blockInterface, i, values[0])] = info;
+		}
+	}
 }
 
-void Shader::SetMat4(const char* name, const glm::mat4& value) const {
-	glUniformMatrix4fv(glGetUniformLocation(programId, name), 1, GL_FALSE, &value[0][0]);
+int32_t Shader::ResolveUniform(const char* name, uint32_t type) const {
+	const UniformInfo* info = FindUniform(name);
+	if (info == nullptr) {
+#ifdef _DEBUG
+		std::cout << "WARNING: Shader " << programId << " has no active uniform named " << name << "\n";
+#endif
+		return -1;
+	}
+	// Samplers are set as ints
+	bool compatible = info->type == type || (type == GL_INT && IsSamplerType(info->type));
+	if (!compatible) {
+#ifdef _DEBUG
+		std::cout << "WARNING: Uniform " << name << " of shader " << programId << " has GL type 0x" << std::hex << info->type
+			<< ", not 0x" << type << std::dec << "\n";
+#endif
+		return -1;
+	}
+	return info->location;
 }
 
 bool Shader::CheckShaderCompilation(uint32_t shader, const char* identifier) {
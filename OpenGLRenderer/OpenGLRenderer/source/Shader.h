@@ -3,27 +3,82 @@
 #include "glm/glm.hpp"
 
 #include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// A uniform location resolved once at setup; setting through an invalid handle does nothing
+template <typename T>
+struct UniformHandle {
+	int32_t location = -1;
+
+	bool IsValid() const { return location >= 0; }
+};
+
+// An active uniform of the default block, as reported by the program interface queries
+struct UniformInfo {
+	int32_t location = -1;
+	// GL type enum, e.g. GL_FLOAT_MAT4 or GL_SAMPLER_2D
+	uint32_t type = 0;
+	int32_t arraySize = 1;
+};
+
+// A uniform block or shader storage block
+struct ShaderBlockInfo {
+	uint32_t index = 0;
+	int32_t binding = 0;
+	// Size the shader expects; 0 for storage blocks ending in an unsized array
+	int32_t dataSize = 0;
+};
 
 class Shader {
 public:
 	Shader(const char* vertexPath, const char* fragmentPath);
 
+	// Goes through GLStateCache, so using an already current program costs nothing
 	void Use();
 
-	void SetBool(const char* name, bool value) const;
+	uint32_t GetId() const { return programId; }
+
+	// Looks name up in the reflection table; in debug builds warns if it is missing or of another type
+	template <typename T>
+	UniformHandle<T> GetUniform(const char* name) const;
 
-	void SetInt(const char* name, int value) const;
+	// Writes straight to the program, so it need not be current
+	void Set(UniformHandle<bool> uniform, bool value) const;
 
-	void SetFloat(const char* name, float value) const;
+	void Set(UniformHandle<int> uniform, int value) const;
 
-	void SetVec3(const char* name, const glm::vec3& value) const;
+	void Set(UniformHandle<float> uniform, float value) const;
 
-	void SetMat4(const char* name, const glm::mat4& value) const;
+	void Set(UniformHandle<glm::vec3> uniform, const glm::vec3& value) const;
+
+	void Set(UniformHandle<glm::mat4> uniform, const glm::mat4& value) const;
+
+	// Null if the linker dropped or never saw the name
+	const UniformInfo* FindUniform(const std::string& name) const;
+
+	const ShaderBlockInfo* FindUniformBlock(const std::string& name) const;
+
+	const ShaderBlockInfo* FindStorageBlock(const std::string& name) const;
+
+	// Sampler uniforms and the texture unit each reads from
+	const std::unordered_map<std::string, int32_t>& GetSamplers() const { return samplers; }
 
 private:
 	bool CheckShaderCompilation(uint32_t shader, const char* identifier);
 
 	bool CheckProgramLinking(uint32_t program);
 
+	// Fills the tables below from the linked program
+	void Reflect();
+
+	// Returns -1 if name is missing or not of type
+	int32_t ResolveUniform(const char* name, uint32_t type) const;
+
 	uint32_t programId;
+
+	std::unordered_map<std::string, UniformInfo> uniforms;
+	std::unordered_map<std::string, ShaderBlockInfo> uniformBlocks;
+	std::unordered_map<std::string, ShaderBlockInfo> storageBlocks;
+	std::unordered_map<std::string, int32_t> samplers;
 };
@@ -1,29 +1,102 @@
 #include "Texture.h"
 #include "glad/glad.h"
 #include "stb/stb_image.h"
+#include "GLState.h"
 
 #include <iostream>
+#include <algorithm>
 
 Texture::Texture(const char* source, bool flip) {
-	id = 0;
-	int width;
-	int height;
-	int numberOfChannels;
-	stbi_set_flip_vertically_on_load(flip);
-	unsigned char* data = stbi_load(source, &width, &height, &numberOfChannels, 0);
-	if (data) {
-		glGenTextures(1, &id);
-		glBindTexture(GL_TEXTURE_2D, id);
-		GLuint textureType = (numberOfChannels == 3) ? GL_RGB : GL_RGBA;
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, textureType, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else {
+	TextureImage image;
+	if (Decode(source, flip, image)) {
+		Upload(image.pixels.get(), image.width, image.height, image.numberOfChannels);
+	}
+}
+
+Texture::Texture(const TextureImage& image) {
+	if (image.pixels) {
+		Upload(image.pixels.get(), image.width, image.height, image.numberOfChannels);
+	}
+}
+
+Texture::Texture(const StagedTexture& staged) {
+	if (staged.name != 0) {
+		texture = GpuResource(GpuResourceType::Texture, staged.name, EstimateBytes(staged.width, staged.height));
+	}
+}
+
+StagedTexture Texture::Stage(const TextureImage& image) {
+	StagedTexture staged;
+	if (!image.pixels) {
+		return staged;
+	}
+
+	int levels = 1;
+	for (int size = std::max(image.width, image.height); size > 1; size /= 2) {
+		levels++;
+	}
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &staged.name);
+	glTextureStorage2D(staged.name, levels, GL_RGB8, image.width, image.height);
+	GLuint textureType = (image.numberOfChannels == 3) ? GL_RGB : GL_RGBA;
+	glTextureSubImage2D(staged.name, 0, 0, 0, image.width, image.height, textureType, GL_UNSIGNED_BYTE, image.pixels.get());
+	glGenerateTextureMipmap(staged.name);
+	staged.width = image.width;
+	staged.height = image.height;
+	return staged;
+}
+
+void Texture::DiscardStaged(StagedTexture& staged) {
+	if (staged.name != 0) {
+		glDeleteTextures(1, &staged.name);
+		staged.name = 0;
+	}
+}
+
+bool Texture::Decode(const char* source, bool flip, TextureImage& image) {
+	// The thread-local flip setting keeps concurrent decodes from racing on stb's global flag
+	stbi_set_flip_vertically_on_load_thread(flip);
+	image.pixels.reset(stbi_load(source, &image.width, &image.height, &image.numberOfChannels, 0));
+	if (!image.pixels) {
 		std::cout << "ERROR: Failed to load texture at " << source << "\n";
+		return false;
+	}
+
+	return true;
+}
+
+bool Texture::DecodeMemory(const unsigned char* bytes, size_t size, bool flip, TextureImage& image) {
+	stbi_set_flip_vertically_on_load_thread(flip);
+	image.pixels.reset(stbi_load_from_memory(bytes, static_cast<int>(size), &image.width, &image.height, &image.numberOfChannels, 0));
+	if (!image.pixels) {
+		std::cout << "ERROR: Failed to decode texture: " << stbi_failure_reason() << "\n";
+		return false;
 	}
-	stbi_image_free(data);
+
+	return true;
+}
+
+void ImageDeleter::operator()(unsigned char* pixels) const {
+	stbi_image_free(pixels);
 }
 
 void Texture::Activate(uint32_t textureUnit) {
-	glBindTextureUnit(textureUnit, id);
+	GLStateCache::Instance().BindTexture(textureUnit, texture.GetName());
+}
+
+size_t Texture::EstimateBytes(int width, int height) {
+	// Uploaded as GL_RGB8 with a full mip chain, which adds about a third
+	size_t baseLevel = static_cast<size_t>(width) * height * 3;
+	return baseLevel + baseLevel / 3;
+}
+
+void Texture::Upload(const unsigned char* data, int width, int height, int numberOfChannels) {
+	uint32_t id;
+	glCreateTextures(GL_TEXTURE_2D, 1, &id);
+	texture = GpuResource(GpuResourceType::Texture, id, EstimateBytes(width, height));
+	// Every bind goes through glBindTextureUnit, so the active unit is always 0
+	GLStateCache::Instance().BindTexture(0, id);
+	GLuint textureType = (numberOfChannels == 3) ? GL_RGB : GL_RGBA;
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, textureType, GL_UNSIGNED_BYTE, data);
+	glGenerateMipmap(GL_TEXTURE_2D);
 }
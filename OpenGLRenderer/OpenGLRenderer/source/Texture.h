@@ -1,20 +1,72 @@
 #pragma once
 
+#include "GpuResources.h"
+
 #include <cstdint>
+#include <cstddef>
 #include <string>
+#include <memory>
+
+// Frees pixels allocated by the image decoder
+struct ImageDeleter {
+	void operator()(unsigned char* pixels) const;
+};
+
+// Decoded pixels waiting for upload; produced off the GL thread
+struct TextureImage {
+	std::unique_ptr<unsigned char, ImageDeleter> pixels;
+	int width = 0;
+	int height = 0;
+	int numberOfChannels = 0;
+};
 
+// A texture created and filled on the upload context, not yet owned by any Texture
+struct StagedTexture {
+	uint32_t name = 0;
+	int width = 0;
+	int height = 0;
+};
+
+// Copies share one GL texture, which is deleted after the last copy is gone and the GPU has caught up
 class Texture {
 public:
+	Texture() = default;
+
 	Texture(const char* source, bool flip = true);
+
+	// Uploads already decoded pixels; must run on the GL thread
+	Texture(const TextureImage& image);
+
+	// Takes ownership of a texture filled on the upload context
+	Texture(const StagedTexture& staged);
+
+	// Creates and fills a texture with its mip chain without registering it, so it is safe on the upload context
+	static StagedTexture Stage(const TextureImage& image);
+
+	// Deletes a staged texture no Texture adopted, from either context
+	static void DiscardStaged(StagedTexture& staged);
+
+	// Decodes an image file without touching GL, so it is safe on any thread
+	static bool Decode(const char* source, bool flip, TextureImage& image);
+
+	// Same as Decode, for an encoded file already in memory
+	static bool DecodeMemory(const unsigned char* bytes, size_t size, bool flip, TextureImage& image);
 	
 	void Activate(uint32_t textureUnit = 0);
 
+	uint32_t GetId() const { return texture.GetName(); }
+
 	const std::string& GetFileName() const { return fileName; }
 
 	void SetFileName(const std::string& newPath) { fileName = newPath; }
 
+	// Base level plus mipmaps, assuming the RGB storage Upload requests
+	static size_t EstimateBytes(int width, int height);
+
 private:
-	uint32_t id;
+	GpuResource texture;
 
 	std::string fileName;
+
+	void Upload(const unsigned char* data, int width, int height, int numberOfChannels);
 };
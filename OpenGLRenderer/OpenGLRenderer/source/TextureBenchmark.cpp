@@ -0,0 +1,90 @@
+#include "TextureBenchmark.h"
+#include "Texture.h"
+#include "ThreadPool.h"
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+namespace {
+	bool ReadFile(const std::string& path, std::vector<unsigned char>& bytes) {
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.good()) {
+			return false;
+		}
+
+		std::streamsize size = file.tellg();
+		file.seekg(0, std::ios::beg);
+		bytes.resize(static_cast<size_t>(size));
+		return static_cast<bool>(file.read(reinterpret_cast<char*>(bytes.data()), size));
+	}
+}
+
+void RunTextureDecodeBenchmark(const std::vector<std::string>& paths, uint32_t repetitions) {
+	std::vector<std::vector<unsigned char>> files;
+	size_t encodedBytes = 0;
+	for (const std::string& path : paths) {
+		std::vector<unsigned char> bytes;
+		if (!ReadFile(path, bytes)) {
+			std::cout << "ERROR: Could not read " << path << "\n";
+			continue;
+		}
+		encodedBytes += bytes.size();
+		files.push_back(std::move(bytes));
+	}
+
+	if (files.empty()) {
+		std::cout << "ERROR: No images to benchmark\n";
+		return;
+	}
+
+	size_t jobCount = files.size() * repetitions;
+	uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::cout << "Texture decode benchmark: " << files.size() << " images, " << repetitions << " repetitions\n";
+	std::cout << "threads   images/s   MPixels/s   encoded MB/s   speedup\n";
+
+	double singleThreadSeconds = 0.0;
+	for (uint32_t threadCount = 1; threadCount <= hardwareThreads; threadCount *= 2) {
+		std::atomic<size_t> decodedPixels{ 0 };
+		auto decode = [&](size_t job) {
+			const std::vector<unsigned char>& bytes = files[job % files.size()];
+			TextureImage image;
+			if (Texture::DecodeMemory(bytes.data(), bytes.size(), true, image)) {
+				decodedPixels += static_cast<size_t>(image.width) * image.height;
+			}
+		};
+
+		// The calling thread takes part in ParallelFor, so the pool gets one worker fewer
+		std::unique_ptr<ThreadPool> pool;
+		if (threadCount > 1) {
+			pool = std::make_unique<ThreadPool>(threadCount - 1);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		if (pool) {
+			pool->ParallelFor(jobCount, decode);
+		}
+		else {
+			for (size_t job = 0; job < jobCount; job++) {
+				decode(job);
+			}
+		}
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		double seconds = elapsed.count();
+		if (threadCount == 1) {
+			singleThreadSeconds = seconds;
+		}
+		std::cout << std::setw(7) << threadCount << std::fixed << std::setprecision(1)
+			<< std::setw(11) << jobCount / seconds
+			<< std::setw(12) << decodedPixels / seconds / 1e6
+			<< std::setw(15) << encodedBytes * repetitions / seconds / (1024.0 * 1024.0)
+			<< std::setw(9) << std::setprecision(2) << singleThreadSeconds / seconds << "x\n";
+		std::cout.unsetf(std::ios::fixed);
+	}
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// Decodes the given images at 1, 2, 4 ... hardware threads and prints throughput for each.
+// Files are read into memory first so only decoding is measured.
+void RunTextureDecodeBenchmark(const std::vector<std::string>& paths, uint32_t repetitions = 4);
@@ -0,0 +1,174 @@
+#include "TextureCache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+	constexpr uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325ull;
+	constexpr uint64_t FNV_PRIME = 0x100000001B3ull;
+
+	uint64_t HashBytes(const unsigned char* bytes, size_t size) {
+		uint64_t hash = FNV_OFFSET_BASIS;
+		for (size_t i = 0; i < size; i++) {
+			hash = (hash ^ bytes[i]) * FNV_PRIME;
+		}
+		return hash;
+	}
+}
+
+TextureCache& TextureCache::Instance() {
+	static TextureCache cache;
+	return cache;
+}
+
+bool TextureCache::ReadSource(const std::string& path, bool flip, TextureSource& source) {
+	std::error_code error;
+	std::filesystem::path resolved = std::filesystem::weakly_canonical(path, error);
+	source.resolvedPath = error ? path : resolved.string();
+	source.flip = flip;
+
+	std::ifstream file(source.resolvedPath, std::ios::binary | std::ios::ate);
+	if (!file.good()) {
+		std::cout << "ERROR: Failed to load texture at " << path << "\n";
+		return false;
+	}
+
+	std::streamsize size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	source.bytes.resize(static_cast<size_t>(size));
+	if (!file.read(reinterpret_cast<char*>(source.bytes.data()), size)) {
+		std::cout << "ERROR: Failed to read texture at " << path << "\n";
+		source.bytes.clear();
+		return false;
+	}
+
+	source.contentHash = HashBytes(source.bytes.data(), source.bytes.size());
+	source.fileSize = source.bytes.size();
+	return true;
+}
+
+bool TextureCache::Contains(const TextureSource& source) const {
+	std::lock_guard<std::mutex> lock(entriesMutex);
+	return pathIndex.count(GetPathKey(source)) != 0 || (source.contentHash != 0 && contentIndex.count(GetContentKey(source)) != 0);
+}
+
+Texture TextureCache::Acquire(const TextureSource& source, const TextureImage& image, StagedTexture* staged) {
+	std::lock_guard<std::mutex> lock(entriesMutex);
+
+	Entry* existing = Find(source);
+	if (existing != nullptr) {
+		existing->referenceCount++;
+		hits++;
+		if (staged != nullptr) {
+			Texture::DiscardStaged(*staged);
+		}
+		return existing->texture;
+	}
+
+	Texture texture;
+	size_t bytes = 0;
+	if (staged != nullptr && staged->name != 0) {
+		texture = Texture(*staged);
+		bytes = Texture::EstimateBytes(staged->width, staged->height);
+		staged->name = 0;
+	}
+	else {
+		// The worker skipped decoding because the texture was resident, but it has been released since
+		TextureImage fallbackImage;
+		const TextureImage* uploadImage = &image;
+		if (!image.pixels) {
+			Texture::Decode(source.resolvedPath.c_str(), source.flip, fallbackImage);
+			uploadImage = &fallbackImage;
+		}
+
+		texture = Texture(*uploadImage);
+		bytes = Texture::EstimateBytes(uploadImage->width, uploadImage->height);
+	}
+
+	misses++;
+	if (texture.GetId() == 0) {
+		return texture;
+	}
+
+	Entry entry;
+	entry.referenceCount = 1;
+	entry.bytes = bytes;
+	entry.pathKey = GetPathKey(source);
+	entry.hasContentKey = source.contentHash != 0;
+	entry.contentKey = GetContentKey(source);
+	entry.texture = texture;
+
+	pathIndex[entry.pathKey] = texture.GetId();
+	if (entry.hasContentKey) {
+		contentIndex[entry.contentKey] = texture.GetId();
+	}
+	residentBytes += entry.bytes;
+	entries[texture.GetId()] = std::move(entry);
+
+	return texture;
+}
+
+void TextureCache::Release(const Texture& texture) {
+	std::lock_guard<std::mutex> lock(entriesMutex);
+
+	auto found = entries.find(texture.GetId());
+	if (found == entries.end()) {
+		return;
+	}
+
+	Entry& entry = found->second;
+	if (--entry.referenceCount > 0) {
+		return;
+	}
+
+	// Dropping the entry's copy lets the registry delete the texture once the GPU is done with it
+	pathIndex.erase(entry.pathKey);
+	if (entry.hasContentKey) {
+		contentIndex.erase(entry.contentKey);
+	}
+	residentBytes -= entry.bytes;
+	entries.erase(found);
+}
+
+TextureCacheStats TextureCache::GetStats() const {
+	std::lock_guard<std::mutex> lock(entriesMutex);
+
+	TextureCacheStats stats;
+	stats.hits = hits;
+	stats.misses = misses;
+	stats.residentTextures = entries.size();
+	stats.residentBytes = residentBytes;
+	return stats;
+}
+
+std::string TextureCache::GetPathKey(const TextureSource& source) {
+	// The hash makes an edited file a different entry, while models still using the old texture keep theirs
+	return source.resolvedPath + (source.flip ? "|flip|" : "|noflip|") + std::to_string(source.contentHash);
+}
+
+TextureCache::ContentKey TextureCache::GetContentKey(const TextureSource& source) {
+	// Flipping changes the uploaded pixels, so it is part of the identity
+	return ContentKey{ source.contentHash, source.fileSize, source.flip };
+}
+
+size_t TextureCache::ContentKeyHash::operator()(const ContentKey& key) const {
+	uint64_t hash = key.hash ^ (static_cast<uint64_t>(key.size) * FNV_PRIME) ^ (key.flip ? 0x9E3779B97F4A7C15ull : 0);
+	return static_cast<size_t>(hash);
+}
+
+TextureCache::Entry* TextureCache::Find(const TextureSource& source) {
+	auto byPath = pathIndex.find(GetPathKey(source));
+	if (byPath != pathIndex.end()) {
+		return &entries[byPath->second];
+	}
+
+	if (source.contentHash != 0) {
+		auto byContent = contentIndex.find(GetContentKey(source));
+		if (byContent != contentIndex.end()) {
+			return &entries[byContent->second];
+		}
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Texture.h"
+
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+// Identifies a texture file independently of how a model spelled its path
+struct TextureSource {
+	std::string resolvedPath;
+	bool flip = true;
+	uint64_t contentHash = 0;
+	// Size of the encoded file; kept after bytes are freed once decoded
+	size_t fileSize = 0;
+	std::vector<unsigned char> bytes;
+};
+
+struct TextureCacheStats {
+	uint32_t hits = 0;
+	uint32_t misses = 0;
+	size_t residentTextures = 0;
+	size_t residentBytes = 0;
+};
+
+// Process-wide, reference-counted textures shared by every model.
+// Entries are found by resolved path, flip and content hash, so a file edited in place is a miss,
+// or by content hash and size alone so identical images under different names share one GL texture. Acquire and Release run on the GL thread;
+// ReadSource and Contains may be called from workers.
+class TextureCache {
+public:
+	static TextureCache& Instance();
+
+	// Resolves the path and reads and hashes the encoded file
+	static bool ReadSource(const std::string& path, bool flip, TextureSource& source);
+
+	// True when a texture for this source is already resident, so decoding can be skipped
+	bool Contains(const TextureSource& source) const;
+
+	// Returns the resident texture with one more reference, uploading image (or decoding the file) on a miss.
+	// A staged texture is adopted instead of uploading on a miss, and discarded on a hit.
+	Texture Acquire(const TextureSource& source, const TextureImage& image, StagedTexture* staged = nullptr);
+
+	// Drops one reference; the GL texture is deleted when none are left
+	void Release(const Texture& texture);
+
+	TextureCacheStats GetStats() const;
+
+private:
+	// A 64-bit hash alone is too weak to trust for sharing between files, so the size must match too
+	struct ContentKey {
+		uint64_t hash = 0;
+		size_t size = 0;
+		bool flip = true;
+
+		bool operator==(const ContentKey& other) const { return hash == other.hash && size == other.size && flip == other.flip; }
+	};
+
+	struct ContentKeyHash {
+		size_t operator()(const ContentKey& key) const;
+	};
+
+	struct Entry {
+		uint32_t referenceCount = 0;
+		size_t bytes = 0;
+		std::string pathKey;
+		bool hasContentKey = false;
+		ContentKey contentKey;
+		Texture texture;
+	};
+
+	mutable std::mutex entriesMutex;
+	std::unordered_map<uint32_t, Entry> entries;
+	std::unordered_map<std::string, uint32_t> pathIndex;
+	std::unordered_map<ContentKey, uint32_t, ContentKeyHash> contentIndex;
+
+	uint32_t hits = 0;
+	uint32_t misses = 0;
+	size_t residentBytes = 0;
+
+	static std::string GetPathKey(const TextureSource& source);
+
+	static ContentKey GetContentKey(const TextureSource& source);
+
+	// Caller holds entriesMutex
+	Entry* Find(const TextureSource& source);
+};
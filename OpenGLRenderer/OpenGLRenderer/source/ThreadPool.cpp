@@ -0,0 +1,101 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <algorithm>
+
+namespace {
+	struct ParallelForState {
+		std::function<void(size_t)> body;
+		size_t count = 0;
+		std::atomic<size_t> next{ 0 };
+		std::atomic<size_t> completed{ 0 };
+		std::mutex doneMutex;
+		std::condition_variable done;
+	};
+
+	// Claims indices until none are left; safe to run after the caller returned since state is shared
+	void RunParallelFor(ParallelForState& state) {
+		size_t index;
+		while ((index = state.next.fetch_add(1)) < state.count) {
+			state.body(index);
+			if (state.completed.fetch_add(1) + 1 == state.count) {
+				std::lock_guard<std::mutex> lock(state.doneMutex);
+				state.done.notify_all();
+			}
+		}
+	}
+}
+
+ThreadPool::ThreadPool(uint32_t threadCount) {
+	// Default to one worker per hardware thread, leaving one for the render loop
+	if (threadCount == 0) {
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	workers.reserve(threadCount);
+	for (uint32_t i = 0; i < threadCount; i++) {
+		workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(tasksMutex);
+		stopping = true;
+	}
+	tasksAvailable.notify_all();
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& body) {
+	if (count == 0) {
+		return;
+	}
+
+	auto state = std::make_shared<ParallelForState>();
+	state->body = body;
+	state->count = count;
+
+	// The calling thread works too, so nested calls from inside a worker cannot deadlock
+	size_t helperCount = std::min(count - 1, workers.size());
+	for (size_t i = 0; i < helperCount; i++) {
+		Enqueue([state]() { RunParallelFor(*state); });
+	}
+	RunParallelFor(*state);
+
+	std::unique_lock<std::mutex> lock(state->doneMutex);
+	state->done.wait(lock, [&state]() { return state->completed.load() == state->count; });
+}
+
+ThreadPool& ThreadPool::Shared() {
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::Enqueue(std::function<void()> task) {
+	{
+		std::lock_guard<std::mutex> lock(tasksMutex);
+		tasks.push(std::move(task));
+	}
+	tasksAvailable.notify_one();
+}
+
+void ThreadPool::WorkerLoop() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(tasksMutex);
+			tasksAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+			if (stopping && tasks.empty()) {
+				return;
+			}
+			task = std::move(tasks.front());
+			tasks.pop();
+		}
+		task();
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// Fixed set of worker threads for CPU-only work; GL calls must stay on the context thread
+class ThreadPool {
+public:
+	explicit ThreadPool(uint32_t threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	template<typename Function>
+	auto Submit(Function&& task) -> std::future<decltype(task())> {
+		using Result = decltype(task());
+		auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(task));
+		std::future<Result> result = packagedTask->get_future();
+		Enqueue([packagedTask]() { (*packagedTask)(); });
+		return result;
+	}
+
+	// Calls body(i) for every i in [0, count) across the workers and the calling thread, returning once all are done
+	void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(workers.size()); }
+
+	// Process-wide pool sized to the hardware
+	static ThreadPool& Shared();
+
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> tasks;
+	std::mutex tasksMutex;
+	std::condition_variable tasksAvailable;
+	bool stopping = false;
+
+	void Enqueue(std::function<void()> task);
+
+	void WorkerLoop();
+};
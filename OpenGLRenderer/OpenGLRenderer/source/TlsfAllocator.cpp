@@ -0,0 +1,277 @@
+#include "TlsfAllocator.h"
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+	uint32_t FindLowestBit(uint32_t value) {
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, value);
+		return index;
+#else
+		return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+	}
+
+	uint32_t FindHighestBit(uint32_t value) {
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse(&index, value);
+		return index;
+#else
+		return 31 - static_cast<uint32_t>(__builtin_clz(value));
+#endif
+	}
+}
+
+float TlsfStats::GetFragmentation() const {
+	uint32_t freeUnits = capacity - used;
+	return freeUnits == 0 ? 0.f : 1.f - static_cast<float>(largestFree) / static_cast<float>(freeUnits);
+}
+
+TlsfAllocator::TlsfAllocator(uint32_t capacity) {
+	for (uint32_t i = 0; i < FL_COUNT; i++) {
+		std::fill(freeHeads[i], freeHeads[i] + SL_COUNT, NONE);
+	}
+	Grow(capacity);
+}
+
+uint32_t TlsfAllocator::Allocate(uint32_t size) {
+	if (size == 0) {
+		return INVALID_OFFSET;
+	}
+
+	uint32_t block = FindFree(size);
+	if (block == NONE) {
+		return INVALID_OFFSET;
+	}
+	RemoveFree(block);
+
+	// Split off the tail so it stays available
+	if (blocks[block].size > size) {
+		uint32_t remainder = CreateBlock(blocks[block].offset + size, blocks[block].size - size);
+		blocks[remainder].previousPhysical = block;
+		blocks[remainder].nextPhysical = blocks[block].nextPhysical;
+		if (blocks[block].nextPhysical != NONE) {
+			blocks[blocks[block].nextPhysical].previousPhysical = remainder;
+		}
+		else {
+			lastBlock = remainder;
+		}
+		blocks[block].nextPhysical = remainder;
+		blocks[block].size = size;
+		InsertFree(remainder);
+	}
+
+	blocks[block].free = false;
+	allocatedBlocks[blocks[block].offset] = block;
+
+	stats.used += size;
+	stats.peakUsed = std::max(stats.peakUsed, stats.used);
+	stats.liveAllocations++;
+	stats.totalAllocations++;
+	stats.largestFree = GetLargestFree();
+	return blocks[block].offset;
+}
+
+void TlsfAllocator::Free(uint32_t offset) {
+	auto found = allocatedBlocks.find(offset);
+	if (found == allocatedBlocks.end()) {
+		return;
+	}
+	uint32_t block = found->second;
+	allocatedBlocks.erase(found);
+
+	stats.used -= blocks[block].size;
+	stats.liveAllocations--;
+	stats.totalFrees++;
+	blocks[block].free = true;
+
+	// Merge with free physical neighbours
+	uint32_t previous = blocks[block].previousPhysical;
+	if (previous != NONE && blocks[previous].free) {
+		RemoveFree(previous);
+		blocks[previous].size += blocks[block].size;
+		blocks[previous].nextPhysical = blocks[block].nextPhysical;
+		if (blocks[block].nextPhysical != NONE) {
+			blocks[blocks[block].nextPhysical].previousPhysical = previous;
+		}
+		else {
+			lastBlock = previous;
+		}
+		DestroyBlock(block);
+		block = previous;
+	}
+
+	uint32_t next = blocks[block].nextPhysical;
+	if (next != NONE && blocks[next].free) {
+		RemoveFree(next);
+		blocks[block].size += blocks[next].size;
+		blocks[block].nextPhysical = blocks[next].nextPhysical;
+		if (blocks[next].nextPhysical != NONE) {
+			blocks[blocks[next].nextPhysical].previousPhysical = block;
+		}
+		else {
+			lastBlock = block;
+		}
+		DestroyBlock(next);
+	}
+
+	InsertFree(block);
+	stats.largestFree = GetLargestFree();
+}
+
+void TlsfAllocator::Grow(uint32_t newCapacity) {
+	if (newCapacity <= stats.capacity) {
+		return;
+	}
+	uint32_t extra = newCapacity - stats.capacity;
+
+	if (lastBlock != NONE && blocks[lastBlock].free) {
+		RemoveFree(lastBlock);
+		blocks[lastBlock].size += extra;
+		InsertFree(lastBlock);
+	}
+	else {
+		uint32_t block = CreateBlock(stats.capacity, extra);
+		blocks[block].free = true;
+		blocks[block].previousPhysical = lastBlock;
+		if (lastBlock != NONE) {
+			blocks[lastBlock].nextPhysical = block;
+		}
+		lastBlock = block;
+		InsertFree(block);
+	}
+
+	stats.capacity = newCapacity;
+	stats.largestFree = GetLargestFree();
+}
+
+uint32_t TlsfAllocator::GetAllocationSize(uint32_t offset) const {
+	auto found = allocatedBlocks.find(offset);
+	return found == allocatedBlocks.end() ? 0 : blocks[found->second].size;
+}
+
+uint32_t TlsfAllocator::GetLargestFree() const {
+	if (firstLevelBitmap == 0) {
+		return 0;
+	}
+
+	uint32_t firstLevel = FindHighestBit(firstLevelBitmap);
+	uint32_t secondLevel = FindHighestBit(secondLevelBitmaps[firstLevel]);
+	uint32_t largest = 0;
+	for (uint32_t block = freeHeads[firstLevel][secondLevel]; block != NONE; block = blocks[block].nextFree) {
+		largest = std::max(largest, blocks[block].size);
+	}
+	return largest;
+}
+
+void TlsfAllocator::MapInsert(uint32_t size, uint32_t& firstLevel, uint32_t& secondLevel) {
+	if (size < SL_COUNT) {
+		firstLevel = 0;
+		secondLevel = size;
+		return;
+	}
+
+	uint32_t highestBit = FindHighestBit(size);
+	secondLevel = (size >> (highestBit - SL_BITS)) ^ SL_COUNT;
+	firstLevel = highestBit - (SL_BITS - 1);
+}
+
+void TlsfAllocator::MapSearch(uint32_t size, uint32_t& firstLevel, uint32_t& secondLevel) {
+	if (size >= SL_COUNT) {
+		uint32_t round = (1u << (FindHighestBit(size) - SL_BITS)) - 1;
+		size = size > UINT32_MAX - round ? UINT32_MAX : size + round;
+	}
+	MapInsert(size, firstLevel, secondLevel);
+}
+
+uint32_t TlsfAllocator::CreateBlock(uint32_t offset, uint32_t size) {
+	uint32_t block;
+	if (!unusedBlocks.empty()) {
+		block = unusedBlocks.back();
+		unusedBlocks.pop_back();
+		blocks[block] = Block();
+	}
+	else {
+		block = static_cast<uint32_t>(blocks.size());
+		blocks.emplace_back();
+	}
+	blocks[block].offset = offset;
+	blocks[block].size = size;
+	return block;
+}
+
+void TlsfAllocator::DestroyBlock(uint32_t block) {
+	unusedBlocks.push_back(block);
+}
+
+void TlsfAllocator::InsertFree(uint32_t block) {
+	uint32_t firstLevel, secondLevel;
+	MapInsert(blocks[block].size, firstLevel, secondLevel);
+
+	uint32_t& head = freeHeads[firstLevel][secondLevel];
+	blocks[block].free = true;
+	blocks[block].previousFree = NONE;
+	blocks[block].nextFree = head;
+	if (head != NONE) {
+		blocks[head].previousFree = block;
+	}
+	head = block;
+
+	firstLevelBitmap |= 1u << firstLevel;
+	secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+	stats.freeBlocks++;
+}
+
+void TlsfAllocator::RemoveFree(uint32_t block) {
+	uint32_t firstLevel, secondLevel;
+	MapInsert(blocks[block].size, firstLevel, secondLevel);
+
+	Block& removed = blocks[block];
+	if (removed.previousFree != NONE) {
+		blocks[removed.previousFree].nextFree = removed.nextFree;
+	}
+	else {
+		freeHeads[firstLevel][secondLevel] = removed.nextFree;
+	}
+	if (removed.nextFree != NONE) {
+		blocks[removed.nextFree].previousFree = removed.previousFree;
+	}
+	removed.previousFree = NONE;
+	removed.nextFree = NONE;
+
+	if (freeHeads[firstLevel][secondLevel] == NONE) {
+		secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+		if (secondLevelBitmaps[firstLevel] == 0) {
+			firstLevelBitmap &= ~(1u << firstLevel);
+		}
+	}
+	stats.freeBlocks--;
+}
+
+uint32_t TlsfAllocator::FindFree(uint32_t size) const {
+	uint32_t firstLevel, secondLevel;
+	MapSearch(size, firstLevel, secondLevel);
+	if (firstLevel >= FL_COUNT) {
+		return NONE;
+	}
+
+	uint32_t secondLevelMap = secondLevel < SL_COUNT ? secondLevelBitmaps[firstLevel] & (~0u << secondLevel) : 0;
+	if (secondLevelMap == 0) {
+		uint32_t firstLevelMap = firstLevel + 1 < FL_COUNT ? firstLevelBitmap & (~0u << (firstLevel + 1)) : 0;
+		if (firstLevelMap == 0) {
+			return NONE;
+		}
+		firstLevel = FindLowestBit(firstLevelMap);
+		secondLevelMap = secondLevelBitmaps[firstLevel];
+	}
+
+	uint32_t block = freeHeads[firstLevel][FindLowestBit(secondLevelMap)];
+	// Rounding up in MapSearch guarantees a fit except when the request itself was clamped
+	return blocks[block].size >= size ? block : NONE;
+}
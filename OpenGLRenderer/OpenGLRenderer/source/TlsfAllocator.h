@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+struct TlsfStats {
+	uint32_t capacity = 0;
+	uint32_t used = 0;
+	uint32_t peakUsed = 0;
+	uint32_t largestFree = 0;
+	uint32_t freeBlocks = 0;
+	uint32_t liveAllocations = 0;
+	uint64_t totalAllocations = 0;
+	uint64_t totalFrees = 0;
+
+	// 0 when all free space is one block, approaching 1 as it splinters
+	float GetFragmentation() const;
+};
+
+// Two-level segregated fit allocator over an abstract range of units (Masmano et al.).
+// It only does the bookkeeping, so it can manage vertices or indices inside a GPU buffer.
+// Allocate and Free are O(1); neighbouring free blocks are merged immediately.
+class TlsfAllocator {
+public:
+	static constexpr uint32_t INVALID_OFFSET = UINT32_MAX;
+
+	explicit TlsfAllocator(uint32_t capacity = 0);
+
+	// Returns INVALID_OFFSET when no free block is large enough
+	uint32_t Allocate(uint32_t size);
+
+	void Free(uint32_t offset);
+
+	// Extends the managed range; the new space joins the last block if it is free
+	void Grow(uint32_t newCapacity);
+
+	uint32_t GetAllocationSize(uint32_t offset) const;
+
+	const TlsfStats& GetStats() const { return stats; }
+
+	// Finds the largest free block by scanning the top non-empty size class
+	uint32_t GetLargestFree() const;
+
+private:
+	static constexpr uint32_t NONE = UINT32_MAX;
+	static constexpr uint32_t SL_BITS = 4;
+	static constexpr uint32_t SL_COUNT = 1 << SL_BITS;
+	static constexpr uint32_t FL_COUNT = 32;
+
+	struct Block {
+		uint32_t offset = 0;
+		uint32_t size = 0;
+		uint32_t previousPhysical = NONE;
+		uint32_t nextPhysical = NONE;
+		uint32_t previousFree = NONE;
+		uint32_t nextFree = NONE;
+		bool free = false;
+	};
+
+	std::vector<Block> blocks;
+	std::vector<uint32_t> unusedBlocks;
+	std::unordered_map<uint32_t, uint32_t> allocatedBlocks;
+	uint32_t lastBlock = NONE;
+
+	uint32_t firstLevelBitmap = 0;
+	uint32_t secondLevelBitmaps[FL_COUNT] = {};
+	uint32_t freeHeads[FL_COUNT][SL_COUNT];
+
+	TlsfStats stats;
+
+	static void MapInsert(uint32_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+
+	// Rounds up so every block in the returned class is large enough
+	static void MapSearch(uint32_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+
+	uint32_t CreateBlock(uint32_t offset, uint32_t size);
+
+	void DestroyBlock(uint32_t block);
+
+	void InsertFree(uint32_t block);
+
+	void RemoveFree(uint32_t block);
+
+	uint32_t FindFree(uint32_t size) const;
+};
@@ -0,0 +1,102 @@
+#include "UploadContext.h"
+#include "glad/glad.h"
+#include "GLFW/glfw3.h"
+
+#include <iostream>
+
+bool UploadTicket::IsComplete() {
+	if (signalled) {
+		return true;
+	}
+	if (!finished.load()) {
+		return false;
+	}
+
+	GLenum result = glClientWaitSync(static_cast<GLsync>(fence), 0, 0);
+	if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+		return false;
+	}
+	glDeleteSync(static_cast<GLsync>(fence));
+	fence = nullptr;
+	signalled = true;
+	return true;
+}
+
+UploadTicket::~UploadTicket() {
+	// Abandoned tickets still own their fence; sync objects are shared, so any context may delete it
+	if (fence != nullptr && glfwGetCurrentContext() != nullptr) {
+		glDeleteSync(static_cast<GLsync>(fence));
+	}
+}
+
+UploadContext& UploadContext::Instance() {
+	static UploadContext context;
+	return context;
+}
+
+bool UploadContext::Start(GLFWwindow* mainWindow) {
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	window = glfwCreateWindow(1, 1, "Upload", NULL, mainWindow);
+	glfwDefaultWindowHints();
+	if (window == NULL) {
+		std::cout << "ERROR: Could not create the shared upload context, uploading on the main context instead\n";
+		return false;
+	}
+
+	stopping = false;
+	uploadThread = std::thread(&UploadContext::ThreadLoop, this);
+	return true;
+}
+
+void UploadContext::Shutdown() {
+	if (!IsRunning()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(jobsMutex);
+		stopping = true;
+	}
+	jobsAvailable.notify_all();
+	uploadThread.join();
+
+	glfwDestroyWindow(window);
+	window = nullptr;
+}
+
+std::shared_ptr<UploadTicket> UploadContext::Submit(std::function<void()> job) {
+	auto ticket = std::make_shared<UploadTicket>();
+	{
+		std::lock_guard<std::mutex> lock(jobsMutex);
+		jobs.push(Job{ std::move(job), ticket });
+	}
+	jobsAvailable.notify_one();
+	return ticket;
+}
+
+void UploadContext::ThreadLoop() {
+	glfwMakeContextCurrent(window);
+
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(jobsMutex);
+			jobsAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+			// Queued jobs still run, so nothing waiting on a ticket is left hanging
+			if (jobs.empty()) {
+				break;
+			}
+			job = std::move(jobs.front());
+			jobs.pop();
+		}
+
+		job.work();
+
+		// The flush makes sure the fence is submitted, so the render thread's polling can see it signal
+		job.ticket->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush();
+		job.ticket->finished = true;
+	}
+
+	glfwMakeContextCurrent(NULL);
+}
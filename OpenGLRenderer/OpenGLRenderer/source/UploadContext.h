@@ -0,0 +1,61 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <functional>
+#include <memory>
+#include <atomic>
+
+struct GLFWwindow;
+
+// Completion of one job on the upload thread; GL objects it created are safe to use on the
+// render context once IsComplete returns true
+class UploadTicket {
+public:
+	// Polls without blocking; call on the render thread
+	bool IsComplete();
+
+	~UploadTicket();
+
+private:
+	friend class UploadContext;
+
+	std::atomic<bool> finished{ false };
+	void* fence = nullptr;
+	bool signalled = false;
+};
+
+// A hidden window whose context shares objects with the main one, current on a dedicated thread.
+// Buffers, textures and sync objects are shared; vertex arrays are not, so jobs must not create them.
+class UploadContext {
+public:
+	static UploadContext& Instance();
+
+	// Call on the main thread after the main context exists; returns false if no shared context could be made
+	bool Start(GLFWwindow* mainWindow);
+
+	// Finishes queued jobs and destroys the context; call before the main context goes away
+	void Shutdown();
+
+	bool IsRunning() const { return uploadThread.joinable(); }
+
+	// Runs job on the upload thread, then fences and flushes so the ticket completes once the GPU has the results
+	std::shared_ptr<UploadTicket> Submit(std::function<void()> job);
+
+private:
+	struct Job {
+		std::function<void()> work;
+		std::shared_ptr<UploadTicket> ticket;
+	};
+
+	GLFWwindow* window = nullptr;
+	std::thread uploadThread;
+	std::queue<Job> jobs;
+	std::mutex jobsMutex;
+	std::condition_variable jobsAvailable;
+	bool stopping = false;
+
+	void ThreadLoop();
+};
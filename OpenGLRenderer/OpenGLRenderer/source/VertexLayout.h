@@ -0,0 +1,207 @@
+#pragma once
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include "Mesh.h"
+#include "VertexQuantization.h"
+
+#include <array>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// One attribute of a CPU vertex struct and the GL format it is read with
+struct VertexAttribute {
+	uint32_t location = 0;
+	int32_t components = 0;
+	uint32_t type = GL_FLOAT;
+	bool normalized = false;
+	// Byte range of the member inside the vertex struct
+	uint32_t offset = 0;
+	uint32_t size = 0;
+};
+
+// Natural GL format of a vertex member type
+template <typename T> struct AttributeTraits;
+template <> struct AttributeTraits<float> { static constexpr int32_t COMPONENTS = 1; static constexpr uint32_t TYPE = GL_FLOAT; };
+template <> struct AttributeTraits<glm::vec2> { static constexpr int32_t COMPONENTS = 2; static constexpr uint32_t TYPE = GL_FLOAT; };
+template <> struct AttributeTraits<glm::vec3> { static constexpr int32_t COMPONENTS = 3; static constexpr uint32_t TYPE = GL_FLOAT; };
+template <> struct AttributeTraits<glm::vec4> { static constexpr int32_t COMPONENTS = 4; static constexpr uint32_t TYPE = GL_FLOAT; };
+
+constexpr uint32_t GetComponentSize(uint32_t type) {
+	switch (type) {
+	case GL_BYTE:
+	case GL_UNSIGNED_BYTE:
+		return 1;
+	case GL_SHORT:
+	case GL_UNSIGNED_SHORT:
+	case GL_HALF_FLOAT:
+		return 2;
+	case GL_INT:
+	case GL_UNSIGNED_INT:
+	case GL_FLOAT:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+// Member read in its natural format
+template <typename Member>
+constexpr VertexAttribute MakeAttribute(uint32_t location, size_t offset) {
+	return VertexAttribute{ location, AttributeTraits<Member>::COMPONENTS, AttributeTraits<Member>::TYPE, false,
+		static_cast<uint32_t>(offset), static_cast<uint32_t>(sizeof(Member)) };
+}
+
+// Member whose bytes are read with an explicit format, e.g. normalized shorts
+template <typename Member>
+constexpr VertexAttribute MakeAttribute(uint32_t location, size_t offset, int32_t components, uint32_t type, bool normalized) {
+	return VertexAttribute{ location, components, type, normalized, static_cast<uint32_t>(offset), static_cast<uint32_t>(sizeof(Member)) };
+}
+
+// A layout is a type with VertexType and a constexpr std::array ATTRIBUTES. This checks that every
+// attribute reads inside its own member, members do not overlap and locations are unique.
+template <typename Layout>
+constexpr bool IsValidLayout() {
+	using VertexType = typename Layout::VertexType;
+	const auto& attributes = Layout::ATTRIBUTES;
+	for (size_t i = 0; i < attributes.size(); i++) {
+		const VertexAttribute& attribute = attributes[i];
+		if (attribute.components < 1 || attribute.components > 4 || GetComponentSize(attribute.type) == 0) {
+			return false;
+		}
+		if (GetComponentSize(attribute.type) * attribute.components > attribute.size || attribute.offset + attribute.size > sizeof(VertexType)) {
+			return false;
+		}
+		for (size_t j = 0; j < i; j++) {
+			if (attributes[j].location == attribute.location) {
+				return false;
+			}
+			if (attributes[j].offset < attribute.offset + attribute.size && attribute.offset < attributes[j].offset + attributes[j].size) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// How a layout's attributes are arranged in the GPU buffer. Interleaved uploads the vertex structs
+// as they are; Deinterleaved stores one tightly packed stream per attribute, one after another.
+template <typename Layout>
+struct Interleaved {
+	using VertexType = typename Layout::VertexType;
+	static constexpr bool INTERLEAVED = true;
+	static constexpr size_t ATTRIBUTE_COUNT = Layout::ATTRIBUTES.size();
+
+	static constexpr const VertexAttribute& GetAttribute(size_t index) { return Layout::ATTRIBUTES[index]; }
+
+	static constexpr uint32_t GetStride(size_t /*attributeIndex*/) { return sizeof(VertexType); }
+
+	// Byte offset of the attribute's first element in the buffer
+	static constexpr size_t GetAttributeOffset(size_t attributeIndex, size_t /*vertexCount*/) { return Layout::ATTRIBUTES[attributeIndex].offset; }
+
+	static constexpr size_t GetBufferSize(size_t vertexCount) { return vertexCount * sizeof(VertexType); }
+
+	static_assert(IsValidLayout<Layout>(), "Vertex layout attributes overlap, repeat a location or do not fit their members");
+};
+
+template <typename Layout>
+struct Deinterleaved {
+	using VertexType = typename Layout::VertexType;
+	static constexpr bool INTERLEAVED = false;
+	static constexpr size_t ATTRIBUTE_COUNT = Layout::ATTRIBUTES.size();
+
+	static constexpr const VertexAttribute& GetAttribute(size_t index) { return Layout::ATTRIBUTES[index]; }
+
+	static constexpr uint32_t GetStride(size_t attributeIndex) { return Layout::ATTRIBUTES[attributeIndex].size; }
+
+	static constexpr size_t GetAttributeOffset(size_t attributeIndex, size_t vertexCount) {
+		size_t offset = 0;
+		for (size_t i = 0; i < attributeIndex; i++) {
+			offset += Layout::ATTRIBUTES[i].size * vertexCount;
+		}
+		return offset;
+	}
+
+	static constexpr size_t GetBufferSize(size_t vertexCount) { return GetAttributeOffset(ATTRIBUTE_COUNT, vertexCount); }
+
+	static_assert(IsValidLayout<Layout>(), "Vertex layout attributes overlap, repeat a location or do not fit their members");
+};
+
+namespace VertexLayoutDetail {
+	template <typename Streams, size_t... I>
+	void SetupAttributes(size_t vertexCount, std::index_sequence<I...>) {
+		// Expands to the same glVertexAttribPointer calls a hand-written setup would make
+		((glEnableVertexAttribArray(Streams::GetAttribute(I).location),
+			glVertexAttribPointer(Streams::GetAttribute(I).location, Streams::GetAttribute(I).components, Streams::GetAttribute(I).type,
+				Streams::GetAttribute(I).normalized, Streams::GetStride(I), (void*)Streams::GetAttributeOffset(I, vertexCount))), ...);
+	}
+
+	template <typename Streams, size_t... I>
+	void PackStreams(const typename Streams::VertexType* vertices, size_t vertexCount, uint8_t* destination, std::index_sequence<I...>) {
+		auto packStream = [&](size_t attributeIndex) {
+			const VertexAttribute& attribute = Streams::GetAttribute(attributeIndex);
+			uint8_t* stream = destination + Streams::GetAttributeOffset(attributeIndex, vertexCount);
+			for (size_t i = 0; i < vertexCount; i++) {
+				std::memcpy(stream + i * attribute.size, reinterpret_cast<const uint8_t*>(vertices + i) + attribute.offset, attribute.size);
+			}
+		};
+		(packStream(I), ...);
+	}
+}
+
+// Describes the vertex data in the bound GL_ARRAY_BUFFER to the bound VAO
+template <typename Streams>
+void SetupVertexAttributes(size_t vertexCount) {
+	VertexLayoutDetail::SetupAttributes<Streams>(vertexCount, std::make_index_sequence<Streams::ATTRIBUTE_COUNT>());
+}
+
+// Rearranges vertex structs into the buffer layout Streams describes
+template <typename Streams>
+void PackVertices(const typename Streams::VertexType* vertices, size_t vertexCount, uint8_t* destination) {
+	if constexpr (Streams::INTERLEAVED) {
+		std::memcpy(destination, vertices, vertexCount * sizeof(typename Streams::VertexType));
+	}
+	else {
+		VertexLayoutDetail::PackStreams<Streams>(vertices, vertexCount, destination, std::make_index_sequence<Streams::ATTRIBUTE_COUNT>());
+	}
+}
+
+// Fills the bound GL_ARRAY_BUFFER and returns its size; interleaved data is uploaded without a copy
+template <typename Streams>
+size_t UploadVertices(const typename Streams::VertexType* vertices, size_t vertexCount) {
+	size_t size = Streams::GetBufferSize(vertexCount);
+	if constexpr (Streams::INTERLEAVED) {
+		glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
+	}
+	else {
+		std::vector<uint8_t> packed(size);
+		PackVertices<Streams>(vertices, vertexCount, packed.data());
+		glBufferData(GL_ARRAY_BUFFER, size, packed.data(), GL_STATIC_DRAW);
+	}
+	return size;
+}
+
+struct StandardVertexLayout {
+	using VertexType = Vertex;
+	static constexpr std::array<VertexAttribute, 3> ATTRIBUTES = { {
+		MakeAttribute<glm::vec3>(0, offsetof(Vertex, Position)),
+		MakeAttribute<glm::vec3>(1, offsetof(Vertex, Normal)),
+		MakeAttribute<glm::vec2>(2, offsetof(Vertex, TexCoords)),
+	} };
+};
+
+// Decoded by BasicTexture.vert; see CompactVertex for the precision of each attribute
+struct CompactVertexLayout {
+	using VertexType = CompactVertex;
+	static constexpr std::array<VertexAttribute, 3> ATTRIBUTES = { {
+		MakeAttribute<decltype(CompactVertex::position)>(0, offsetof(CompactVertex, position), 3, GL_UNSIGNED_SHORT, true),
+		MakeAttribute<decltype(CompactVertex::normal)>(1, offsetof(CompactVertex, normal), 2, GL_SHORT, true),
+		MakeAttribute<decltype(CompactVertex::texCoords)>(2, offsetof(CompactVertex, texCoords), 2, GL_HALF_FLOAT, false),
+	} };
+};
+
+static_assert(sizeof(Vertex) == 32 && sizeof(CompactVertex) == 16, "Vertex sizes no longer match their layouts");
@@ -0,0 +1,102 @@
+#include "VertexQuantization.h"
+#include "Mesh.h"
+#include "glm/gtc/packing.hpp"
+
+#include <cmath>
+
+namespace {
+	float SignNotZero(float value) {
+		return value >= 0.f ? 1.f : -1.f;
+	}
+
+	// Tries the four snorm16 neighbours of the encoded normal and keeps the one that decodes closest
+	void PackNormal(const glm::vec3& normal, int16_t packed[2]) {
+		glm::vec2 encoded = VertexQuantization::EncodeOctahedral(normal);
+		glm::vec2 base = glm::floor(encoded * 32767.f);
+
+		float bestDot = -2.f;
+		for (int i = 0; i < 4; i++) {
+			glm::vec2 candidate = glm::clamp((base + glm::vec2(i & 1, i >> 1)) / 32767.f, -1.f, 1.f);
+			float dot = glm::dot(VertexQuantization::DecodeOctahedral(candidate), normal);
+			if (dot > bestDot) {
+				bestDot = dot;
+				packed[0] = static_cast<int16_t>(glm::packSnorm1x16(candidate.x));
+				packed[1] = static_cast<int16_t>(glm::packSnorm1x16(candidate.y));
+			}
+		}
+	}
+}
+
+PositionDecode VertexQuantization::Quantize(const Vertex* vertices, size_t vertexCount, std::vector<CompactVertex>& result) {
+	PositionDecode decode;
+	result.resize(vertexCount);
+	if (vertexCount == 0) {
+		return decode;
+	}
+
+	glm::vec3 minimum = vertices[0].Position;
+	glm::vec3 maximum = minimum;
+	for (size_t i = 1; i < vertexCount; i++) {
+		minimum = glm::min(minimum, vertices[i].Position);
+		maximum = glm::max(maximum, vertices[i].Position);
+	}
+
+	decode.offset = minimum;
+	decode.scale = maximum - minimum;
+	// A flat axis only ever decodes to the offset
+	glm::vec3 inverseScale(0.f);
+	for (int axis = 0; axis < 3; axis++) {
+		if (decode.scale[axis] > 0.f) {
+			inverseScale[axis] = 1.f / decode.scale[axis];
+		}
+	}
+
+	for (size_t i = 0; i < vertexCount; i++) {
+		const Vertex& vertex = vertices[i];
+		CompactVertex& compact = result[i];
+
+		glm::vec3 position = (vertex.Position - decode.offset) * inverseScale;
+		compact.position[0] = glm::packUnorm1x16(position.x);
+		compact.position[1] = glm::packUnorm1x16(position.y);
+		compact.position[2] = glm::packUnorm1x16(position.z);
+		compact.position[3] = 0;
+
+		float length = glm::length(vertex.Normal);
+		PackNormal(length > 0.f ? vertex.Normal / length : glm::vec3(0.f, 0.f, 1.f), compact.normal);
+
+		compact.texCoords[0] = glm::packHalf1x16(vertex.TexCoords.x);
+		compact.texCoords[1] = glm::packHalf1x16(vertex.TexCoords.y);
+	}
+
+	return decode;
+}
+
+glm::vec2 VertexQuantization::EncodeOctahedral(const glm::vec3& normal) {
+	glm::vec3 n = normal / (std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z));
+	if (n.z >= 0.f) {
+		return glm::vec2(n.x, n.y);
+	}
+	return glm::vec2((1.f - std::fabs(n.y)) * SignNotZero(n.x), (1.f - std::fabs(n.x)) * SignNotZero(n.y));
+}
+
+glm::vec3 VertexQuantization::DecodeOctahedral(const glm::vec2& encoded) {
+	// Matches DecodeOctahedral in BasicTexture.vert
+	glm::vec3 n(encoded.x, encoded.y, 1.f - std::fabs(encoded.x) - std::fabs(encoded.y));
+	float t = std::fmax(-n.z, 0.f);
+	n.x += n.x >= 0.f ? -t : t;
+	n.y += n.y >= 0.f ? -t : t;
+	return glm::normalize(n);
+}
+
+bool VertexQuantization::NarrowIndices(const uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint16_t>& result) {
+	result.clear();
+	if (vertexCount > 65536) {
+		return false;
+	}
+
+	result.resize(indexCount);
+	for (size_t i = 0; i < indexCount; i++) {
+		result[i] = static_cast<uint16_t>(indices[i]);
+	}
+	return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct Vertex;
+
+// 16-byte GPU vertex, half the size of Vertex. Decoded in the vertex shader when compactVertices is set.
+// Precision bounds:
+//  - Position: unorm16 within the mesh AABB, so about extent / 131070 per axis (0.08 mm on a 10 m mesh)
+//  - Normal: octahedral snorm16, under 0.01 degrees
+//  - TexCoords: half floats, relative error 2^-11 (under 1/4096 absolute for UVs in [0, 1])
+struct CompactVertex {
+	uint16_t position[4];
+	int16_t normal[2];
+	uint16_t texCoords[2];
+};
+
+// Maps unorm position components back to object space: position = offset + value * scale
+struct PositionDecode {
+	glm::vec3 offset = glm::vec3(0.f);
+	glm::vec3 scale = glm::vec3(1.f);
+};
+
+namespace VertexQuantization {
+	PositionDecode Quantize(const Vertex* vertices, size_t vertexCount, std::vector<CompactVertex>& result);
+
+	// Octahedral encoding into [-1, 1]^2
+	glm::vec2 EncodeOctahedral(const glm::vec3& normal);
+
+	glm::vec3 DecodeOctahedral(const glm::vec2& encoded);
+
+	// Narrows indices when every vertex fits in 16 bits; returns false and leaves result empty otherwise
+	bool NarrowIndices(const uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint16_t>& result);
+}
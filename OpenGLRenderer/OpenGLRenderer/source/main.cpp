@@ -10,15 +10,34 @@
 #include "Shader.h"
 #include "Camera.h"
 #include "Model.h"
+#include "ModelLoader.h"
+#include "MeshCache.h"
+#include "TextureCache.h"
+#include "SceneGeometry.h"
+#include "GpuResources.h"
+#include "RingBuffer.h"
+#include "UploadContext.h"
+#include "GLState.h"
+#include "FrameConstants.h"
+#include "FrameSnapshot.h"
+#include "RenderThread.h"
+#include "TextureBenchmark.h"
+#include "LodScaleCheck.h"
+#include "ProcessMemory.h"
 
 #include <iostream>
 #include <cstdint>
+#include <cstring>
+#include <chrono>
 
 constexpr uint32_t SCREEN_WIDTH = 1920;
 constexpr uint32_t SCREEN_HEIGHT = 1080;
 constexpr uint32_t DIALOG_WIDTH = static_cast<uint32_t>(SCREEN_WIDTH * 0.8);
 constexpr uint32_t DIALOG_HEIGHT = static_cast<uint32_t>(SCREEN_HEIGHT * 0.8);
 constexpr glm::mat4 IDENTITY_4X4 = glm::mat4(1.0f);
+constexpr double MODEL_UPLOAD_BUDGET_MS = 4.0;
+constexpr size_t MODEL_UPLOAD_BUDGET_BYTES = 32 * 1024 * 1024;
+constexpr size_t GEOMETRY_COMPACTION_BUDGET_BYTES = 1024 * 1024;
 
 Camera MainCamera(glm::vec3(0.0f, 0.0f, 3.0f));
 float CameraSpeed = 2.5f;
@@ -27,9 +46,34 @@ float LastMouseX;
 float LastMouseY;
 float DeltaTime = 0.0f;
 float TimeLastFrame = 0.0f;
-
+int FramebufferWidth = SCREEN_WIDTH;
+int FramebufferHeight = SCREEN_HEIGHT;
+
+// Owns the GL context between startup and shutdown
+RenderThread FrameRenderer;
+// What the render thread last reported, read by the UI on the main thread
+FrameFeedback RenderFeedback;
+// Last size the render thread applied
+int ViewportWidth = 0;
+int ViewportHeight = 0;
+
+// Render thread only, like everything else that touches GL
 Model* LoadedModel = nullptr;
+ModelLoader BackgroundModelLoader;
 bool FlipModelTextures = true;
+bool OptimizeModelMeshes = false;
+bool GenerateModelLods = false;
+bool UseLods = true;
+bool BuildModelMeshlets = false;
+bool BatchModelMeshes = false;
+bool CompactModelVertices = false;
+bool KeepCpuGeometry = false;
+bool CullMeshlets = true;
+bool CullSubmeshes = true;
+bool UseMultiDrawIndirect = true;
+bool UseVertexPulling = false;
+bool UseParallelRecording = true;
+float LodErrorPixels = 1.f;
 bool CullBackfaces = true;
 
 GLFWwindow* InitalizeWindow();
@@ -38,12 +82,22 @@ void MouseMovementCallback(GLFWwindow* window, double xPos, double yPos);
 void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 void MouseScrollCallback(GLFWwindow* window, double xOffset, double yOffset);
 void UpdateDeltaTime();
-void DrawGui();
+void DrawGui(FrameSnapshot& frame);
+void RenderFrame(FrameSnapshot& frame, FrameFeedback& feedback, const Shader& modelShader, const Pipeline& modelPipeline);
+void GatherFeedback(const FrameSnapshot& frame, FrameFeedback& feedback);
 void ShutdownRenderer();
 void ProcessInput(GLFWwindow* window);
 void PrintErrors();
 
-int main() {
+int main(int argc, char** argv) {
+	if (argc > 1 && std::strcmp(argv[1], "--benchmark-decode") == 0) {
+		RunTextureDecodeBenchmark(std::vector<std::string>(argv + 2, argv + argc));
+		return 0;
+	}
+	if (argc > 1 && std::strcmp(argv[1], "--check-lod-scale") == 0) {
+		return RunLodScaleCheck() ? 0 : 1;
+	}
+
 	GLFWwindow* window = InitalizeWindow();
 	if (window == nullptr) {
 		return -1;
@@ -57,46 +111,76 @@ int main() {
 	// Shaders
 	Shader modelShaderProgram("shaders/BasicTexture.vert", "shaders/BasicTexture.frag");
 
+	CheckFrameConstantsLayout(modelShaderProgram);
+
+	PipelineDesc modelPipelineDesc;
+	modelPipelineDesc.program = modelShaderProgram.GetId();
+	const Pipeline& culledModelPipeline = GLStateCache::Instance().CreatePipeline(modelPipelineDesc);
+	modelPipelineDesc.cull = CullMode::None;
+	const Pipeline& unculledModelPipeline = GLStateCache::Instance().CreatePipeline(modelPipelineDesc);
+
 	glfwSwapInterval(1);
-	glEnable(GL_DEPTH_TEST);
 
+	// From here on the context belongs to the render thread; this thread handles events, camera and UI
+	FrameRenderer.Start(window, [&](FrameSnapshot& frame, FrameFeedback& feedback) {
+		RenderFrame(frame, feedback, modelShaderProgram, frame.cullBackfaces ? culledModelPipeline : unculledModelPipeline);
+	});
+
+	uint64_t frameIndex = 0;
 	while (!glfwWindowShouldClose(window)) {
 		//
-		// Framestart 
+		// Framestart
 		//
+		// Blocks only while the render thread is still drawing the frame before last, so input is sampled after any wait
+		FrameSnapshot& frame = FrameRenderer.BeginFrame();
+		FrameRenderer.GetFeedback(RenderFeedback);
+
+		glfwPollEvents();
 		UpdateDeltaTime();
 		ProcessInput(window);
-		
-		//
-		// Rendering
-		//
-		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		frame.frameIndex = frameIndex++;
+		frame.inputTime = std::chrono::steady_clock::now();
+		frame.framebufferWidth = FramebufferWidth;
+		frame.framebufferHeight = FramebufferHeight;
+		frame.load = LoadRequest();
 
 		glm::mat4 view = MainCamera.GetViewMatrix();
 		glm::mat4 projection = glm::perspective(glm::radians(MainCamera.GetZoom()), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 100.0f);
 
-		// Draw the container
-		modelShaderProgram.Use();
-		modelShaderProgram.SetMat4("view", view);
-		modelShaderProgram.SetMat4("projection", projection);
-		modelShaderProgram.SetMat4("model", modelMatrix);
-		if (LoadedModel != nullptr) {
-			LoadedModel->Draw(modelShaderProgram);
-		}
-
-		// Draw the GUI
-		DrawGui();
+		// One upload serves every program, however many are drawn with
+		FrameConstants& frameConstants = frame.constants;
+		frameConstants.view = view;
+		frameConstants.projection = projection;
+		frameConstants.viewProjection = projection * view;
+		frameConstants.cameraPosition = glm::vec4(MainCamera.GetPosition(), 1.f);
+		frameConstants.time = glm::vec2(static_cast<float>(glfwGetTime()), DeltaTime);
+		frameConstants.viewport = glm::vec2(static_cast<float>(SCREEN_WIDTH), static_cast<float>(SCREEN_HEIGHT));
+
+		DrawContext& drawContext = frame.drawContext;
+		drawContext.model = modelMatrix;
+		drawContext.view = view;
+		drawContext.projection = projection;
+		drawContext.viewportHeight = static_cast<float>(SCREEN_HEIGHT);
+		drawContext.maxErrorPixels = LodErrorPixels;
+		drawContext.enableLods = UseLods;
+		drawContext.cullMeshlets = CullMeshlets;
+		drawContext.cullSubmeshes = CullSubmeshes;
+		drawContext.multiDrawIndirect = UseMultiDrawIndirect;
+		drawContext.vertexPulling = UseVertexPulling;
+		drawContext.parallelRecording = UseParallelRecording;
+		frame.cullBackfaces = CullBackfaces;
+
+		// Build the GUI; the render thread draws a copy of it
+		DrawGui(frame);
 		ImGui::Render();
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-		
-		//
-		// Swap Buffers and Poll Events
-		//
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		bool textureUpdates = UiDrawSnapshot::HasTextureUpdates(ImGui::GetDrawData());
+		frame.ui.Capture(ImGui::GetDrawData(), textureUpdates);
+
+		// The renderer writes to ImGui's textures when it updates them, so this thread must not run ahead of that frame
+		FrameRenderer.Publish(textureUpdates);
 	}
 
+	FrameRenderer.Stop();
 	ShutdownRenderer();
 	
 	return 0;
@@ -115,6 +199,7 @@ GLFWwindow* InitalizeWindow() {
 		return nullptr;
 	}
 	glfwMakeContextCurrent(window);
+	glfwGetFramebufferSize(window, &FramebufferWidth, &FramebufferHeight);
 	glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
 	glfwSetCursorPosCallback(window, MouseMovementCallback);
 	glfwSetMouseButtonCallback(window, MouseButtonCallback);
@@ -126,6 +211,9 @@ GLFWwindow* InitalizeWindow() {
 		return nullptr;
 	}
 
+	// Without it, model loads create their GL objects on this context within the upload budget
+	UploadContext::Instance().Start(window);
+
 	IMGUI_CHECKVERSION();
 	ImGui::CreateContext();
 	ImGuiIO& io = ImGui::GetIO();
@@ -137,7 +225,9 @@ GLFWwindow* InitalizeWindow() {
 }
 
 void FramebufferSizeCallback(GLFWwindow* window, int width, int height) {
-	glViewport(0, 0, width, height);
+	// Applied by the render thread, which owns the context
+	FramebufferWidth = width;
+	FramebufferHeight = height;
 }
 
 void MouseMovementCallback(GLFWwindow* window, double xPos, double yPos) {
@@ -183,8 +273,7 @@ void UpdateDeltaTime() {
 	TimeLastFrame = currentTime;
 }
 
-void DrawGui() {
-	ImGui_ImplOpenGL3_NewFrame();
+void DrawGui(FrameSnapshot& frame) {
 	ImGui_ImplGlfw_NewFrame();
 	ImGui::NewFrame();
 
@@ -206,30 +295,170 @@ void DrawGui() {
 	ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
 	ImGui::Checkbox("Flip Textures", &FlipModelTextures);
 
+	ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+	ImGui::Checkbox("Optimize Meshes", &OptimizeModelMeshes);
+
+	ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+	ImGui::Checkbox("Generate LODs", &GenerateModelLods);
+
+	ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+	ImGui::Checkbox("Build Meshlets", &BuildModelMeshlets);
+
+	ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+	ImGui::Checkbox("Batch Meshes", &BatchModelMeshes);
+
+	ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+	ImGui::Checkbox("Compact Vertices", &CompactModelVertices);
+
+	ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+	ImGui::Checkbox("Keep CPU Geometry", &KeepCpuGeometry);
+
 	ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
 	ImGui::Checkbox("Cull Backfaces", &CullBackfaces);
-	if (CullBackfaces) {
-		glEnable(GL_CULL_FACE);
-	}
-	else {
-		glDisable(GL_CULL_FACE);
-	}
 
 	ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
 	ImGui::SliderFloat("Camera Speed", &CameraSpeed, 0.f, 100.f);
 	MainCamera.SetSpeed(CameraSpeed);
 
+	MeshCacheStats cacheStats = MeshCache::GetStats();
+	ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+	ImGui::Text("Mesh Cache: %u hits, %u misses, last load %.1f ms (%s)", cacheStats.hits, cacheStats.misses,
+		cacheStats.lastLoadMilliseconds, cacheStats.lastWasHit ? "hit" : "miss");
+
+	TextureCacheStats textureStats = TextureCache::Instance().GetStats();
+	uint32_t textureLookups = textureStats.hits + textureStats.misses;
+	ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+	ImGui::Text("Textures: %zu resident, %.1f MB, hit rate %.0f%%", textureStats.residentTextures,
+		textureStats.residentBytes / (1024.0 * 1024.0), textureLookups == 0 ? 0.0 : 100.0 * textureStats.hits / textureLookups);
+
+	const FrameFeedback& feedback = RenderFeedback;
+	if (feedback.hasModel && feedback.hasOptimizationReport) {
+		const OptimizationReport& report = feedback.optimizationReport;
+		ImGui::Text("Mesh Optimizer: ACMR %.2f -> %.2f, ATVR %.2f -> %.2f, vertices %zu -> %zu", report.before.acmr, report.after.acmr,
+			report.before.atvr, report.after.atvr, report.verticesBefore, report.verticesAfter);
+	}
+
+	ImGui::Checkbox("Use LODs", &UseLods);
+	ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+	ImGui::SliderFloat("LOD Error (px)", &LodErrorPixels, 0.1f, 16.f);
+	if (feedback.hasModel) {
+		const DrawStats& drawStats = feedback.drawStats;
+		ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+		ImGui::Text("Triangles drawn: %zu", drawStats.triangles);
+		ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+		ImGui::Text("Geometry: %.1f MB", feedback.geometryBytes / (1024.0 * 1024.0));
+
+		ProcessMemory memory = ProcessMemory::Query();
+		ImGui::Text("CPU geometry: %.1f MB, RSS: %.1f MB (peak %.1f MB)", feedback.cpuGeometryBytes / (1024.0 * 1024.0),
+			memory.residentBytes / (1024.0 * 1024.0), memory.peakResidentBytes / (1024.0 * 1024.0));
+
+		ImGui::Checkbox("Multi-Draw Indirect", &UseMultiDrawIndirect);
+		ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+		ImGui::Text("Submission: %u commands in %u buckets, %u draw calls, %.3f ms", drawStats.commands, drawStats.buckets,
+			drawStats.drawCalls, drawStats.submitMilliseconds);
+		ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+		ImGui::Text("Render queue: %zu keys sorted in %.3f ms (%u radix passes)", drawStats.queue.entries, drawStats.queue.sortMilliseconds,
+			drawStats.queue.radixPasses);
+
+		ImGui::Checkbox("Vertex Pulling", &UseVertexPulling);
+		ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+		ImGui::Text("Vertex array binds: %u", drawStats.vertexArrayBinds);
+
+		ImGui::Checkbox("Parallel Recording", &UseParallelRecording);
+		ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+		ImGui::Text("Command lists: %u slices, %.1f KB, prepare %.3f ms, record %.3f ms, replay %.3f ms", drawStats.recordingSlices,
+			drawStats.commandListBytes / 1024.0, drawStats.prepareMilliseconds, drawStats.recordMilliseconds, drawStats.replayMilliseconds);
+
+		ImGui::Checkbox("Cull Meshlets", &CullMeshlets);
+		ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+		ImGui::Text("Meshlets: %u tested, %u outside frustum, %u back-facing", drawStats.meshlets.tested,
+			drawStats.meshlets.frustumCulled, drawStats.meshlets.backfaceCulled);
+
+		// Each mesh is one full-detail draw call without multi-draw indirect, so this is the draw count before and after batching
+		ImGui::Checkbox("Cull Submeshes", &CullSubmeshes);
+		ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+		ImGui::Text("Static batching: %zu -> %zu draws; submeshes %u tested, %u outside frustum",
+			feedback.sourceMeshCount, feedback.meshCount, drawStats.submeshes.tested, drawStats.submeshes.frustumCulled);
+
+		// Levels arrive a frame after the header opens, since only then does the render thread copy them
+		frame.wantLodDetails = ImGui::CollapsingHeader("Levels of Detail");
+		if (frame.wantLodDetails) {
+			for (size_t i = 0; i < feedback.meshLods.size(); i++) {
+				const MeshLodFeedback& mesh = feedback.meshLods[i];
+				ImGui::Text("Mesh %zu: LOD %u/%u, %zu meshlets", i, mesh.activeLod, mesh.levelCount, mesh.meshlets);
+				for (uint32_t lod = 0; lod < mesh.levelCount; lod++) {
+					const LodLevelFeedback& level = feedback.lodLevels[mesh.firstLevel + lod];
+					ImGui::SameLine(0.f, SCREEN_WIDTH / 40);
+					ImGui::Text("[%u] %u tris, err %.4f", lod, level.triangles, level.error);
+				}
+			}
+		}
+	}
+
+	const SceneGeometryStats& geometryStats = feedback.geometryStats;
+	ImGui::Text("Scene buffers: %.1f / %.1f MB (peak %.1f MB) in %zu pools, %u live ranges, %llu allocated, %llu freed, "
+		"fragmentation %.0f%%, %u growths, %.1f MB compacted", geometryStats.usedBytes / (1024.0 * 1024.0),
+		geometryStats.capacityBytes / (1024.0 * 1024.0), geometryStats.peakUsedBytes / (1024.0 * 1024.0), geometryStats.pools,
+		geometryStats.liveAllocations, static_cast<unsigned long long>(geometryStats.totalAllocations),
+		static_cast<unsigned long long>(geometryStats.totalFrees), geometryStats.fragmentation * 100.0, geometryStats.growths,
+		geometryStats.compactedBytes / (1024.0 * 1024.0));
+
+	const RingBufferStats& ringStats = feedback.ringStats;
+	ImGui::Text("Ring buffer: %.1f KB of %.1f KB per frame (peak %.1f KB), %llu fence waits (last %.3f ms, total %.1f ms), %llu overflows",
+		ringStats.lastFrameBytes / 1024.0, ringStats.regionBytes / 1024.0, ringStats.peakFrameBytes / 1024.0,
+		static_cast<unsigned long long>(ringStats.waits), ringStats.lastWaitMilliseconds, ringStats.totalWaitMilliseconds,
+		static_cast<unsigned long long>(ringStats.overflows));
+
+	const GpuResourceTypeStats& textureObjects = feedback.resourceStats[static_cast<uint32_t>(GpuResourceType::Texture)];
+	const GpuResourceTypeStats& bufferObjects = feedback.resourceStats[static_cast<uint32_t>(GpuResourceType::Buffer)];
+	const GpuResourceTypeStats& vertexArrayObjects = feedback.resourceStats[static_cast<uint32_t>(GpuResourceType::VertexArray)];
+	ImGui::Text("GPU objects: %u textures (%.1f MB), %u buffers (%.1f MB), %u vertex arrays; %u awaiting delete (%.1f MB)",
+		textureObjects.live, textureObjects.liveBytes / (1024.0 * 1024.0), bufferObjects.live, bufferObjects.liveBytes / (1024.0 * 1024.0),
+		vertexArrayObjects.live, textureObjects.pendingDeletes + bufferObjects.pendingDeletes + vertexArrayObjects.pendingDeletes,
+		(textureObjects.pendingBytes + bufferObjects.pendingBytes) / (1024.0 * 1024.0));
+
+	const GLStateStats& stateStats = feedback.stateStats;
+	ImGui::Text("GL state: elided %llu/%llu program, %llu/%llu vertex array, %llu/%llu texture, %llu/%llu buffer, %llu/%llu fixed-function calls; %u pipeline switches",
+		static_cast<unsigned long long>(stateStats.programs.GetElided()), static_cast<unsigned long long>(stateStats.programs.requested),
+		static_cast<unsigned long long>(stateStats.vertexArrays.GetElided()), static_cast<unsigned long long>(stateStats.vertexArrays.requested),
+		static_cast<unsigned long long>(stateStats.textures.GetElided()), static_cast<unsigned long long>(stateStats.textures.requested),
+		static_cast<unsigned long long>(stateStats.buffers.GetElided()), static_cast<unsigned long long>(stateStats.buffers.requested),
+		static_cast<unsigned long long>(stateStats.fixedFunction.GetElided()), static_cast<unsigned long long>(stateStats.fixedFunction.requested),
+		stateStats.pipelineSwitches);
+
+	RenderThreadStats renderStats = FrameRenderer.GetStats();
+	ImGui::Text("Render thread: frame %llu drawn, %llu published; hand-off %.3f ms, input to swap %.1f ms (peak %.1f ms), render %.2f ms, "
+		"main waited %.2f ms, render waited %.2f ms", static_cast<unsigned long long>(renderStats.framesRendered),
+		static_cast<unsigned long long>(renderStats.framesPublished), renderStats.handOffMilliseconds, renderStats.latencyMilliseconds,
+		renderStats.peakLatencyMilliseconds, renderStats.renderMilliseconds, renderStats.mainWaitMilliseconds, renderStats.renderWaitMilliseconds);
+
+	if (feedback.loaderBusy) {
+		ImGui::ProgressBar(feedback.loaderProgress, ImVec2(SCREEN_WIDTH / 8, 0.f), feedback.loaderStage);
+		ImGui::SameLine();
+		if (ImGui::Button("Cancel Load")) {
+			frame.load.cancel = true;
+		}
+		ImGui::SameLine(0.f, SCREEN_WIDTH / 20);
+		ImGui::Text("Upload slice: %.2f ms, %.1f MB (max %.2f ms, budget %.1f ms / %.1f MB, %s)", feedback.lastSliceMilliseconds,
+			feedback.lastSliceBytes / (1024.0 * 1024.0), feedback.maxSliceMilliseconds, MODEL_UPLOAD_BUDGET_MS,
+			MODEL_UPLOAD_BUDGET_BYTES / (1024.0 * 1024.0), UploadContext::Instance().IsRunning() ? "upload thread" : "main context");
+	}
 
 	ImGui::PopItemWidth();
 	
 	// File Dialog
 	if (ImGuiFileDialog::Instance()->Display("OpenModelDialog")) {
 		if (ImGuiFileDialog::Instance()->IsOk()) {
-			std::string filePathName = ImGuiFileDialog::Instance()->GetFilePathName();
-			if (LoadedModel != nullptr) {
-				delete LoadedModel;
-			}
-			LoadedModel = new Model(filePathName, FlipModelTextures);
+			frame.load.start = true;
+			frame.load.path = ImGuiFileDialog::Instance()->GetFilePathName();
+			ImportOptions& options = frame.load.options;
+			options.flipTextures = FlipModelTextures;
+			options.optimizeMeshes = OptimizeModelMeshes;
+			options.generateLods = GenerateModelLods;
+			options.buildMeshlets = BuildModelMeshlets;
+			options.batchMeshes = BatchModelMeshes;
+			options.compactVertices = CompactModelVertices;
+			options.cpuGeometry = KeepCpuGeometry ? CpuGeometryPolicy::Keep : CpuGeometryPolicy::Drop;
 			ImGuiFileDialog::Instance()->Close();
 		}
 
@@ -239,7 +468,109 @@ void DrawGui() {
 	ImGui::End();
 }
 
+void RenderFrame(FrameSnapshot& frame, FrameFeedback& feedback, const Shader& modelShader, const Pipeline& modelPipeline) {
+	GLStateCache::Instance().BeginFrame();
+	GpuResourceRegistry::Instance().Update();
+	RingBuffer::Instance().BeginFrame();
+	SceneGeometry::Instance().Update(GEOMETRY_COMPACTION_BUDGET_BYTES);
+
+	if (frame.load.cancel) {
+		BackgroundModelLoader.Cancel();
+	}
+	if (frame.load.start) {
+		BackgroundModelLoader.Start(frame.load.path, frame.load.options);
+	}
+
+	// Swap in a background-loaded model once all of it is on the GPU
+	Model* finishedModel = BackgroundModelLoader.Update(UploadBudget{ MODEL_UPLOAD_BUDGET_MS, MODEL_UPLOAD_BUDGET_BYTES });
+	if (finishedModel != nullptr) {
+		delete LoadedModel;
+		LoadedModel = finishedModel;
+	}
+
+	//
+	// Rendering
+	//
+	if (frame.framebufferWidth != ViewportWidth || frame.framebufferHeight != ViewportHeight) {
+		ViewportWidth = frame.framebufferWidth;
+		ViewportHeight = frame.framebufferHeight;
+		glViewport(0, 0, ViewportWidth, ViewportHeight);
+	}
+	glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	BindFrameConstants(frame.constants);
+
+	// Draw the container
+	GLStateCache::Instance().SetPipeline(modelPipeline);
+	if (LoadedModel != nullptr) {
+		LoadedModel->Draw(modelShader, frame.drawContext);
+	}
+
+	// Draw the GUI
+	if (frame.ui.IsValid()) {
+		ImGui_ImplOpenGL3_NewFrame();
+		// Restores every piece of state it changes, so GLStateCache stays accurate
+		ImGui_ImplOpenGL3_RenderDrawData(frame.ui.GetDrawData());
+	}
+
+	GatherFeedback(frame, feedback);
+}
+
+void GatherFeedback(const FrameSnapshot& frame, FrameFeedback& feedback) {
+	feedback.frameIndex = frame.frameIndex;
+
+	feedback.hasModel = LoadedModel != nullptr;
+	feedback.meshLods.clear();
+	feedback.lodLevels.clear();
+	if (LoadedModel != nullptr) {
+		feedback.drawStats = LoadedModel->GetLastDrawStats();
+		feedback.hasOptimizationReport = LoadedModel->HasOptimizationReport();
+		feedback.optimizationReport = LoadedModel->GetOptimizationReport();
+		feedback.geometryBytes = LoadedModel->GetGeometryBytes();
+		feedback.cpuGeometryBytes = LoadedModel->GetCpuGeometryBytes();
+		feedback.sourceMeshCount = LoadedModel->GetSourceMeshCount();
+		feedback.meshCount = LoadedModel->GetMeshCount();
+
+		if (frame.wantLodDetails) {
+			for (size_t i = 0; i < LoadedModel->GetMeshCount(); i++) {
+				const Mesh& mesh = LoadedModel->GetMesh(i);
+				MeshLodFeedback meshLods;
+				meshLods.activeLod = LoadedModel->GetActiveLod(i);
+				meshLods.meshlets = mesh.GetMeshletCount();
+				meshLods.firstLevel = static_cast<uint32_t>(feedback.lodLevels.size());
+				meshLods.levelCount = mesh.GetLodCount();
+				for (uint32_t lod = 0; lod < mesh.GetLodCount(); lod++) {
+					feedback.lodLevels.push_back(LodLevelFeedback{ mesh.GetLod(lod).indexCount / 3, mesh.GetLod(lod).error });
+				}
+				feedback.meshLods.push_back(meshLods);
+			}
+		}
+	}
+
+	feedback.loaderBusy = BackgroundModelLoader.IsBusy();
+	feedback.loaderProgress = BackgroundModelLoader.GetProgress();
+	feedback.loaderStage = BackgroundModelLoader.GetStageName();
+	feedback.lastSliceMilliseconds = BackgroundModelLoader.GetLastSliceMilliseconds();
+	feedback.maxSliceMilliseconds = BackgroundModelLoader.GetMaxSliceMilliseconds();
+	feedback.lastSliceBytes = BackgroundModelLoader.GetLastSliceBytes();
+
+	feedback.geometryStats = SceneGeometry::Instance().GetStats();
+	feedback.ringStats = RingBuffer::Instance().GetStats();
+	for (uint32_t i = 0; i < static_cast<uint32_t>(GpuResourceType::Count); i++) {
+		feedback.resourceStats[i] = GpuResourceRegistry::Instance().GetStats(static_cast<GpuResourceType>(i));
+	}
+	feedback.stateStats = GLStateCache::Instance().GetLastFrameStats();
+}
+
 void ShutdownRenderer() {
+	BackgroundModelLoader.Shutdown();
+	UploadContext::Instance().Shutdown();
+	delete LoadedModel;
+	LoadedModel = nullptr;
+	SceneGeometry::Instance().Shutdown();
+	RingBuffer::Instance().Shutdown();
+	GpuResourceRegistry::Instance().Shutdown();
 	PrintErrors();
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();